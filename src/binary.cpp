@@ -162,12 +162,26 @@ void execute(
     if (do_compile)
     {
         proc::processor_t processor;
-        util::print_console("Compiling knowledge-base ...");
+        bool do_append = phillip->flag("kb_append");
+        util::print_console(do_append ?
+            "Appending to knowledge-base ..." : "Compiling knowledge-base ...");
 
-        kb::kb()->prepare_compile();
+        if (do_append)
+            kb::kb()->prepare_append();
+        else
+            kb::kb()->prepare_compile();
 
-        processor.add_component(new proc::compile_kb_t());
-        processor.process(inputs);
+        if (phillip->flag("kb_parallel_compile"))
+        {
+            proc::parallel_kb_compiler_t compiler(
+                phillip->param_int("kb_thread_num", 1));
+            compiler.process(inputs);
+        }
+        else
+        {
+            processor.add_component(new proc::compile_kb_t());
+            processor.process(inputs);
+        }
 
         kb::kb()->finalize();
 
@@ -201,6 +215,17 @@ void execute(
         kb::kb()->prepare_query();
         phillip->check_validity();
 
+        if (phillip->flag("kb_prewarm_distance_cache"))
+        {
+            hash_set<kb::arity_id_t> arities;
+
+            for (const auto &ipt : parsed_inputs)
+            for (auto lit : ipt.obs.get_all_literals())
+                arities.insert(kb::kb()->search_arity_id(*lit));
+
+            kb::kb()->prewarm_distance_cache(arities);
+        }
+
         // SOLVE EACH OBSERVATION
         for (int i = 0; i < parsed_inputs.size(); ++i)
         {
@@ -220,7 +245,6 @@ void execute(
                 }
 
                 util::print_console_fmt("Observation #%d: %s", i, ipt.name.c_str());
-                kb::kb()->clear_distance_cache();
 
 #ifdef _DEBUG
                 /* DO NOT HANDLE EXCEPTIONS TO LET THE DEBUGGER CATCH AN EXCEPTION. */
@@ -424,6 +448,11 @@ bool _interpret_option(
                 phillip->set_param("path_sol_out", util::normalize_path(val));
                 return true;
             }
+            else if (key == "lhs_bin")
+            {
+                phillip->set_param("path_lhs_bin_out", util::normalize_path(val));
+                return true;
+            }
             else
                 return false;
         }
@@ -491,6 +520,7 @@ bool _interpret_option(
         if (spl.size() == 1)
         {
             phillip->set_param("kb_thread_num", spl[0]);
+            phillip->set_param("lhs_thread_num", spl[0]);
             phillip->set_param("gurobi_thread_num", spl[0]);
             return true;
         }
@@ -501,6 +531,11 @@ bool _interpret_option(
                 phillip->set_param("kb_thread_num", spl[1]);
                 return true;
             }
+            else if (spl[0] == "lhs")
+            {
+                phillip->set_param("lhs_thread_num", spl[1]);
+                return true;
+            }
             else if (spl[0] == "grb")
             {
                 phillip->set_param("gurobi_thread_num", spl[1]);
@@ -557,9 +592,21 @@ bool preprocess(const execution_configure_t &config, phillip_main_t *phillip)
     float max_dist = phillip->param_float("kb_max_distance", -1.0);
     int thread_num = phillip->param_int("kb_thread_num", 1);
     bool disable_stop_word = phillip->flag("disable_stop_word");
+    std::string rm_format_key = phillip->param("kb_rm_format");
+    int axiom_cache_size = phillip->param_int("kb_axiom_cache_size", 65536);
+    int distance_cache_mb = phillip->param_int("kb_distance_cache_mb", 64);
+    kb::reachable_matrix_format_e rm_format = kb::RM_FORMAT_PLAIN;
     std::string dist_key = config.dist_key.empty() ? "basic" : config.dist_key;
     std::string tab_key = config.tab_key.empty() ? "null" : config.tab_key;
 
+    if (rm_format_key == "compact8")
+        rm_format = kb::RM_FORMAT_COMPACT8;
+    else if (rm_format_key == "compact16")
+        rm_format = kb::RM_FORMAT_COMPACT16;
+    else if (not rm_format_key.empty() and rm_format_key != "plain")
+        throw phillip_exception_t(
+        "Invalid value of kb_rm_format: " + rm_format_key, true);
+
     for (auto n : config.target_obs_names)
         phillip->add_target(n);
     for (auto n : config.excluded_obs_names)
@@ -576,7 +623,9 @@ bool preprocess(const execution_configure_t &config, phillip_main_t *phillip)
         generate(config.sol_key, phillip);
 
     kb::knowledge_base_t::setup(
-        config.kb_name, max_dist, thread_num, disable_stop_word);
+        config.kb_name, max_dist, thread_num, disable_stop_word, rm_format,
+        (axiom_cache_size > 0) ? axiom_cache_size : 0,
+        (distance_cache_mb > 0) ? (size_t)distance_cache_mb << 20 : 0);
     kb::knowledge_base_t::instance()->set_distance_provider(dist_key, phillip);
     kb::knowledge_base_t::instance()->set_category_table(tab_key, phillip);
 
@@ -620,6 +669,8 @@ void print_usage()
         "    -c dist=<NAME> : Sets a component to define relatedness between predicates.",
         "    -c tab=<NAME> : Sets a component for making category-table.",
         "    -k <NAME> : Sets the prefix of the path of the compiled knowledge base.",
+        "    -f kb_append : Appends axioms to the compiled knowledge base.",
+        "    -f kb_parallel_compile : Parses input files in parallel (one thread per input file).",
         "",
         "  Options in inference-mode or learning-mode:",
         "    -c lhs=<NAME> : Sets a component for making latent hypotheses sets.",
@@ -630,14 +681,18 @@ void print_usage()
         "    -o lhs=<PATH> : Prints the XML of the latent hypothesis set for debug to the given file path.",
         "    -o ilp=<PATH> : Prints the XML of the ILP problem for debug to the given file path.",
         "    -o sol=<PATH> : Prints the XML of the ILP solution for debug to the given file path.",
+        "    -o lhs_bin=<PATH> : Writes the binary of latent hypotheses sets to the given file path.",
+        "    -p path_lhs_bin_in=<PATH> : Loads latent hypotheses sets from the binary instead of enumerating them.",
         "    -t <NAME> : Solves only the observation of corresponding name.",
         "    -t !<NAME> : Excludes the observation which corresponds with given name.",
         "    -G : Forces to satisfy the requirements.",
         "    -H : Adds the human readable hypothesis to output XMLs.",
+        "    -P lhs=<INT> : Sets the number of threads to check unifiability in latent hypotheses sets.",
         "    -T <INT>  : Sets timeout of the whole inference in seconds.",
         "    -T lhs=<INT> : Sets timeout of the creation of latent hypotheses sets in seconds.",
         "    -T ilp=<INT> : Sets timeout of the conversion into ILP problem in seconds.",
         "    -T sol=<INT> : Sets timeout of the optimization of ILP problem in seconds.",
+        "    -f kb_prewarm_distance_cache : Caches distances from observed predicates beforehand.",
         "",
         "  Wiki: https://github.com/kazeto/phillip/wiki"};
 
@@ -10,6 +10,9 @@
 #include <direct.h>
 #else
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
 #endif
 
 const int FAILURE_MKDIR = -1;
@@ -18,26 +21,181 @@ const int FAILURE_MKDIR = -1;
 namespace phil
 {
 
-std::mutex string_hash_t::ms_mutex_hash;
-std::mutex string_hash_t::ms_mutex_unknown;
-hash_map<std::string, unsigned> string_hash_t::ms_hashier;
-std::vector<std::string> string_hash_t::ms_strs;
-unsigned string_hash_t::ms_issued_variable_count = 0;
+string_hash_t::shard_t string_hash_t::ms_shards[string_hash_t::NUM_SHARDS];
+std::atomic<string_hash_t::entry_t*> string_hash_t::ms_chunks[string_hash_t::NUM_CHUNKS];
+std::atomic<unsigned> string_hash_t::ms_num_strs(1);
+std::atomic<unsigned> string_hash_t::ms_issued_variable_count(0);
+std::atomic<unsigned> string_hash_t::ms_num_unknown_names(1);
+std::mutex string_hash_t::ms_mutex_for_unknown_names;
+
+
+string_hash_t string_hash_t::get_unknown_hash()
+{
+    unsigned hash = get_unknown_hash(++ms_issued_variable_count);
+    string_hash_t out(hash, FLAG_UNKNOWN);
+#ifdef _DEBUG
+    out.m_string = out.string();
+#endif
+    return out;
+}
+
+
+unsigned string_hash_t::get_unknown_hash(unsigned idx)
+{
+    // OTHERWISE THE HASH WOULD WRAP INTO THE RANGE OF INTERNED STRINGS.
+    if (idx == 0 or idx >= UNKNOWN_TAG)
+        throw phillip_exception_t("Too many unknown terms have been issued.");
+
+    if (idx >= ms_num_unknown_names.load(std::memory_order_acquire))
+    {
+        std::lock_guard<std::mutex> lock(ms_mutex_for_unknown_names);
+        unsigned num = ms_num_unknown_names.load(std::memory_order_relaxed);
+
+        for (; num <= idx; ++num)
+        {
+            entry_t *e = get_writable_entry(UNKNOWN_TAG | num);
+            e->str = "_u" + std::to_string(num);
+            e->flags = FLAG_UNKNOWN;
+        }
+        ms_num_unknown_names.store(num, std::memory_order_release);
+    }
+
+    return UNKNOWN_TAG | idx;
+}
+
+
+unsigned string_hash_t::parse_unknown_index(const std::string &str)
+{
+    if (str.size() < 3 or str.size() > 11) return 0;
+    if (str[0] != '_' or str[1] != 'u' or str[2] == '0') return 0;
+
+    unsigned long idx(0);
+    for (size_t i = 2; i < str.size(); ++i)
+    {
+        if (str[i] < '0' or str[i] > '9') return 0;
+        idx = idx * 10 + (str[i] - '0');
+    }
+
+    return (idx < UNKNOWN_TAG) ? static_cast<unsigned>(idx) : 0;
+}
+
+
+string_hash_t::entry_t* string_hash_t::get_writable_entry(unsigned hash)
+{
+    std::atomic<entry_t*> &chunk = ms_chunks[hash >> CHUNK_BITS];
+    entry_t *ptr = chunk.load(std::memory_order_acquire);
+
+    if (ptr == NULL)
+    {
+        // ANOTHER THREAD MAY ALLOCATE THE SAME CHUNK IN THE MEANTIME.
+        entry_t *allocated = new entry_t[1u << CHUNK_BITS];
+        if (chunk.compare_exchange_strong(ptr, allocated, std::memory_order_acq_rel))
+            ptr = allocated;
+        else
+            delete[] allocated;
+    }
+
+    return ptr + (hash & ((1u << CHUNK_BITS) - 1));
+}
+
+
+unsigned string_hash_t::get_hash(const std::string &str, unsigned char *flags)
+{
+    if (str.empty())
+    {
+        *flags = 0;
+        return 0;
+    }
+
+    // ONLY NAMES OF UNKNOWN TERMS ISSUED IN THE CURRENT INFERENCE
+    // ARE MAPPED TO THEIR IDS. OTHER STRINGS LIKE "_u<N>" ARE INTERNED AS USUAL,
+    // SO THAT USER INPUT CANNOT MAKE US WRITE NAMES UP TO ARBITRARY N.
+    unsigned unknown = parse_unknown_index(str);
+    if (unknown > 0 and unknown <= ms_issued_variable_count.load())
+    {
+        *flags = FLAG_UNKNOWN;
+        return get_unknown_hash(unknown);
+    }
+
+    shard_t &sh = ms_shards[std::hash<std::string>()(str) % NUM_SHARDS];
+    std::lock_guard<std::mutex> lock(sh.mutex);
+
+    auto found = sh.hashes.find(str);
+    if (found != sh.hashes.end())
+    {
+        *flags = get_entry(found->second)->flags;
+        return found->second;
+    }
+
+    unsigned hash = ms_num_strs++;
+    if (hash >= UNKNOWN_TAG)
+        throw phillip_exception_t("Too many strings have been interned.");
+
+    entry_t &e = *get_writable_entry(hash);
+    e.str = str;
+    e.flags = compute_flags(str);
+    sh.hashes[str] = hash;
+    *flags = e.flags;
+
+    return hash;
+}
+
+
+unsigned char string_hash_t::compute_flags(const std::string &str)
+{
+    assert(not str.empty());
+    if (str.empty()) return 0;
+
+    unsigned char flags(0);
+
+    if (std::isupper(str.at(0)))
+        flags |= FLAG_CONSTANT;
+    if (str.size() >= 2 and str.at(0) == '_' and str.at(1) == 'u')
+        flags |= FLAG_UNKNOWN;
+#ifndef DISABLE_HARD_TERM
+    if (str.front() == '*')
+        flags |= FLAG_HARD_TERM;
+#endif
+
+    return flags;
+}
+
+
+string_hash_t literal_t::get_arity_hash(
+    const string_hash_t &pred, int term_num, bool is_negated)
+{
+    // EACH THREAD HAS ITS OWN CACHE, SO THAT LOOKING UP NEEDS NO LOCK.
+    static thread_local hash_map<uint64_t, string_hash_t> cache;
+
+    uint64_t key =
+        (static_cast<uint64_t>(pred.get_hash()) << 8) |
+        (static_cast<uint64_t>(term_num) << 1) | (is_negated ? 1 : 0);
+    auto found = cache.find(key);
+
+    if (found != cache.end())
+        return found->second;
+
+    string_hash_t arity(get_arity(pred, term_num, is_negated));
+    cache[key] = arity;
+    return arity;
+}
 
 
 literal_t::literal_t(const sexp::stack_t &s)
     : truth(true)
 {
+    predicate_t pred;
+
     if (s.is_functor())
     {
         const std::string &str = s.children[0]->children[0]->str;
         if (str.at(0) == '!')
         {
             truth = false;
-            predicate = predicate_t(str.substr(1));
+            pred = str.substr(1);
         }
         else
-            predicate = predicate_t(str);
+            pred = str;
 
         for (int i = 1; i < s.children.size(); i++)
         {
@@ -49,16 +207,17 @@ literal_t::literal_t(const sexp::stack_t &s)
         }
     }
     else
-        predicate = s.children[0]->str;
+        pred = s.children[0]->str;
 
-    if (predicate.length() >= 255)
+    if (pred.length() >= 255)
     {
         util::print_warning_fmt(
             "Following predicate is too long and shortened: \"%s\"",
-            predicate.c_str());
-        predicate = predicate.substr(0, 250);
+            pred.c_str());
+        pred = pred.substr(0, 250);
     }
 
+    predicate = pred;
     regularize();
 }
 
@@ -66,7 +225,7 @@ literal_t::literal_t(const sexp::stack_t &s)
 bool literal_t::operator > (const literal_t &x) const
 {
     if (truth != x.truth) return truth;
-    if (predicate != x.predicate) return (predicate > x.predicate);
+    if (predicate != x.predicate) return (predicate.string() > x.predicate.string());
     if (terms.size() != x.terms.size())
         return (terms.size() > x.terms.size());
 
@@ -82,7 +241,7 @@ bool literal_t::operator > (const literal_t &x) const
 bool literal_t::operator < (const literal_t &x) const
 {
     if (truth != x.truth) return not truth;
-    if (predicate != x.predicate) return (predicate < x.predicate);
+    if (predicate != x.predicate) return (predicate.string() < x.predicate.string());
     if (terms.size() != x.terms.size())
         return (terms.size() < x.terms.size());
 
@@ -134,13 +293,13 @@ void literal_t::print( std::string *p_out_str, bool f_colored ) const
     if( not truth ) (*p_out_str) += "!";
 
 #ifdef _WIN32
-    (*p_out_str) += predicate;
+    (*p_out_str) += predicate.string();
 #else
     if( f_colored )
         (*p_out_str) +=
-            util::format( "\33[40m%s\33[0m", predicate.c_str() );
+            util::format( "\33[40m%s\33[0m", predicate.string().c_str() );
     else
-        (*p_out_str) += predicate;
+        (*p_out_str) += predicate.string();
 #endif
 
     for( int i=0; i<terms.size(); i++ )
@@ -188,17 +347,18 @@ size_t literal_t::read_binary( const char *bin )
     int i_buf;
 
     n += util::binary_to_string(bin, &s_buf);
-    predicate = predicate_t(s_buf);
+    predicate = s_buf;
 
     n += util::binary_to_num(bin + n, &i_buf);
-    terms.assign(i_buf, term_t());
+    terms.clear();
     for( int i=0; i<i_buf; ++i )
     {
         n += util::binary_to_string(bin + n, &s_buf);
-        terms[i] = term_t(s_buf);
+        terms.push_back(term_t(s_buf));
     }
 
     n += util::binary_to_bool(bin + n, &truth);
+    update_arity();
 
     return n;
 }
@@ -217,6 +377,62 @@ std::ostream& operator<<(std::ostream& os, const literal_t& lit)
 
 
 
+namespace kb
+{
+
+
+void arity_pattern_view_t::encode(const arity_pattern_t &p, std::vector<word_t> *out)
+{
+    out->clear();
+    out->reserve(
+        3 + std::get<0>(p).size() + 4 * std::get<1>(p).size() + std::get<2>(p).size());
+
+    out->push_back(std::get<0>(p).size());
+    out->push_back(std::get<1>(p).size());
+    out->push_back(std::get<2>(p).size());
+
+    for (auto id : std::get<0>(p))
+        out->push_back(static_cast<word_t>(id));
+
+    for (auto ht : std::get<1>(p))
+    {
+        out->push_back(static_cast<word_t>(ht.first.first));
+        out->push_back(static_cast<word_t>(ht.first.second));
+        out->push_back(static_cast<word_t>(ht.second.first));
+        out->push_back(static_cast<word_t>(ht.second.second));
+    }
+
+    for (auto i : std::get<2>(p))
+        out->push_back(static_cast<word_t>(i));
+}
+
+
+bool arity_pattern_view_t::operator<(const arity_pattern_view_t &x) const
+{
+    // COMPARES EACH PART LEXICOGRAPHICALLY, AS std::tuple DOES.
+    const word_t *p1 = m_data + 3, *p2 = x.m_data + 3;
+    size_t n1[3] = { num_arities(), 4 * num_hard_terms(), num_soft_unifiable_literals() };
+    size_t n2[3] = { x.num_arities(), 4 * x.num_hard_terms(), x.num_soft_unifiable_literals() };
+
+    for (int i = 0; i < 3; ++i)
+    {
+        if (std::lexicographical_compare(p1, p1 + n1[i], p2, p2 + n2[i]))
+            return true;
+        if (std::lexicographical_compare(p2, p2 + n2[i], p1, p1 + n1[i]))
+            return false;
+
+        p1 += n1[i];
+        p2 += n2[i];
+    }
+
+    return false;
+}
+
+
+} // end of kb
+
+
+
 namespace util
 {
 
@@ -301,6 +517,177 @@ void cdb_data_t::finalize()
 }
 
 
+bool mapped_file_t::open(const std::string &filename)
+{
+    close();
+
+#ifdef _WIN32
+    std::ifstream fi(filename.c_str(), std::ios::binary | std::ios::in);
+    if (fi.fail()) return false;
+
+    size_t size = get_file_size(fi);
+    char *buf = new char[size + 1];
+    fi.read(buf, size);
+
+    m_data = buf;
+    m_size = size;
+    m_is_mapped = false;
+#else
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    m_size = static_cast<size_t>(st.st_size);
+
+    if (m_size == 0)
+    {
+        /* mmap REJECTS ZERO-LENGTH MAPPINGS. */
+        m_data = new char[1];
+        m_is_mapped = false;
+    }
+    else
+    {
+        void *ptr = ::mmap(NULL, m_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (ptr == MAP_FAILED)
+        {
+            ::close(fd);
+            m_size = 0;
+            return false;
+        }
+        m_data = static_cast<const char*>(ptr);
+        m_is_mapped = true;
+    }
+
+    ::close(fd);
+#endif
+
+    return true;
+}
+
+
+void mapped_file_t::close()
+{
+    if (m_data == NULL) return;
+
+#ifndef _WIN32
+    if (m_is_mapped)
+        ::munmap(const_cast<char*>(m_data), m_size);
+    else
+#endif
+        delete[] m_data;
+
+    m_data = NULL;
+    m_size = 0;
+    m_is_mapped = false;
+}
+
+
+thread_pool_t::thread_pool_t(int num_threads)
+    : m_job(NULL), m_num_indices(0), m_next_index(0),
+      m_generation(0), m_num_working(0), m_do_stop(false)
+{
+    for (int th = 1; th < num_threads; ++th)
+        m_workers.emplace_back([this, th]() { work(th); });
+}
+
+
+thread_pool_t::~thread_pool_t()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_do_stop = true;
+    }
+    m_cv_start.notify_all();
+
+    for (auto &t : m_workers)
+        t.join();
+}
+
+
+void thread_pool_t::run(size_t n, const std::function<void(int, size_t)> &f)
+{
+    if (m_workers.empty() or n <= 1)
+    {
+        for (size_t i = 0; i < n; ++i)
+            f(0, i);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_job = &f;
+        m_num_indices = n;
+        m_next_index = 0;
+        m_num_working = static_cast<int>(m_workers.size());
+        m_exception = std::exception_ptr();
+        ++m_generation;
+    }
+    m_cv_start.notify_all();
+
+    process(0);
+
+    std::exception_ptr e;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cv_finish.wait(lock, [this]() { return m_num_working == 0; });
+        m_job = NULL;
+        std::swap(e, m_exception);
+    }
+
+    if (e) std::rethrow_exception(e);
+}
+
+
+void thread_pool_t::work(int th)
+{
+    unsigned long long generation(0);
+
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv_start.wait(lock, [&]() { return m_do_stop or m_generation != generation; });
+            if (m_do_stop) return;
+            generation = m_generation;
+        }
+
+        process(th);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (--m_num_working == 0)
+                m_cv_finish.notify_one();
+        }
+    }
+}
+
+
+void thread_pool_t::process(int th)
+{
+    for (size_t i = m_next_index++; i < m_num_indices; i = m_next_index++)
+    {
+        try
+        {
+            (*m_job)(th, i);
+        }
+        catch (...)
+        {
+            // KEEPS ONLY THE FIRST EXCEPTION AND LETS OTHER THREADS STOP SOON.
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (not m_exception)
+                m_exception = std::current_exception();
+            m_next_index = m_num_indices;
+        }
+    }
+}
+
+
 void xml_element_t::print(std::ostream *os) const
 {
     std::function<void(const xml_element_t&)>
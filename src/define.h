@@ -7,6 +7,9 @@
 #include <cstdio>
 #include <cstdarg>
 #include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <cassert>
 #include <ctime>
 #include <chrono>
 #include <sys/stat.h>
@@ -18,8 +21,12 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <atomic>
 #include <functional>
 #include <exception>
+#include <stdexcept>
 
 #include "./lib/cdbpp.h"
 #include "./s_expression.h"
@@ -64,6 +71,7 @@ typedef std::tuple<
     std::vector<arity_id_t>,
     std::list<std::pair<term_pos_t, term_pos_t> >,
     std::list<small_size_t> > arity_pattern_t;
+typedef unsigned int arity_pattern_id_t;
 typedef std::pair<std::pair<kb::arity_id_t, term_idx_t>,
                   std::pair<kb::arity_id_t, term_idx_t> > hard_term_pair_t;
 
@@ -80,6 +88,47 @@ soft_unifiable_literal_indices(const arity_pattern_t &p)
 inline bool is_backward(std::pair<axiom_id_t, bool> &p)
 { return p.second; }
 
+
+/** A read-only view of an arity-pattern in the flat table of patterns.
+ *  A pattern is a sequence of words, which consists of
+ *  the numbers of arities, hard-term pairs and soft-unifiable literals
+ *  followed by their elements, so that it is read without any allocation. */
+class arity_pattern_view_t
+{
+public:
+    typedef uint32_t word_t;
+
+    arity_pattern_view_t(const word_t *data = NULL) : m_data(data) {}
+
+    /** Encodes a pattern into words in the layout of this. */
+    static void encode(const arity_pattern_t &p, std::vector<word_t> *out);
+
+    inline size_t num_arities() const { return m_data[0]; }
+    inline size_t num_hard_terms() const { return m_data[1]; }
+    inline size_t num_soft_unifiable_literals() const { return m_data[2]; }
+
+    inline arity_id_t arity(size_t i) const { return m_data[3 + i]; }
+    inline std::pair<term_pos_t, term_pos_t> hard_term(size_t i) const
+    {
+        const word_t *p = m_data + 3 + num_arities() + 4 * i;
+        return std::make_pair(
+            term_pos_t(p[0], static_cast<term_idx_t>(p[1])),
+            term_pos_t(p[2], static_cast<term_idx_t>(p[3])));
+    }
+
+    inline small_size_t soft_unifiable_literal_index(size_t i) const
+    {
+        return static_cast<small_size_t>(
+            m_data[3 + num_arities() + 4 * num_hard_terms() + i]);
+    }
+
+    /** Compares patterns in the same order as arity_pattern_t. */
+    bool operator<(const arity_pattern_view_t &x) const;
+
+private:
+    const word_t *m_data;
+};
+
 }
 
 namespace pg
@@ -102,22 +151,37 @@ enum verboseness_t
 
 
 /** Hash of string.
- * Use instead of std::string for acceleration. */
+ * Use instead of std::string for acceleration.
+ * The hash 0 is reserved for the empty string,
+ * so that default-constructed instances represent it.
+ * Unknown terms "_uN" issued by get_unknown_hash() do not enter the interning table.
+ * Their hashes are N tagged with UNKNOWN_TAG, which are issued again
+ * after reset_unknown_hash_count().
+ * A string "_uN" is resolved to the issued one only if N has been issued
+ * in the current inference, otherwise it is interned as an ordinary string. */
 class string_hash_t
 {
 public:
-    static inline string_hash_t get_unknown_hash();
+    /** Issues a new unknown term without locking the interning table. */
+    static string_hash_t get_unknown_hash();
+
+    /** Returns the instance of the hash, which has been issued by this class.
+     *  Used to restore terms from packed keys. */
+    static inline string_hash_t from_hash(unsigned hash);
+
+    /** Reclaims ids of unknown terms issued so far.
+     *  Call this only when no term issued so far is in use. */
     static inline void reset_unknown_hash_count();
 
     inline string_hash_t();
-    inline string_hash_t(const string_hash_t& h);
+    string_hash_t(const string_hash_t& h) = default;
     inline string_hash_t(const std::string& s);
 
     inline const std::string& string() const;
     inline operator const std::string& () const;
 
     inline string_hash_t& operator=(const std::string &s);
-    inline string_hash_t& operator=(const string_hash_t &h);
+    string_hash_t& operator=(const string_hash_t &h) = default;
 
     inline bool operator>(const string_hash_t &x) const;
     inline bool operator<(const string_hash_t &x) const;
@@ -128,23 +192,70 @@ public:
 
     inline const unsigned& get_hash() const { return m_hash; }
 
-    inline bool is_constant() const { return m_is_constant; }
-    inline bool is_unknown()  const { return m_is_unknown; }
-    inline bool is_hard_term() const { return m_is_hard_term; }
+    inline bool is_constant() const { return (m_flags & FLAG_CONSTANT) != 0; }
+    inline bool is_unknown()  const { return (m_flags & FLAG_UNKNOWN) != 0; }
+    inline bool is_hard_term() const { return (m_flags & FLAG_HARD_TERM) != 0; }
 
 private:
-    /** Assign a hash to str if needed, and return the hash of str. */
-    static inline unsigned get_hash(std::string str);
+    enum flag_e { FLAG_CONSTANT = 0x01, FLAG_UNKNOWN = 0x02, FLAG_HARD_TERM = 0x04 };
 
-    static std::mutex ms_mutex_hash, ms_mutex_unknown;
-    static hash_map<std::string, unsigned> ms_hashier;
-    static std::vector<std::string> ms_strs;
-    static unsigned ms_issued_variable_count;
+    /** An interned string and its flags, which are computed on interning. */
+    struct entry_t
+    {
+        entry_t() : flags(0) {}
+        std::string str;
+        unsigned char flags;
+    };
+
+    /** A shard of the table from strings to their hashes. */
+    struct shard_t
+    {
+        std::mutex mutex;
+        hash_map<std::string, unsigned> hashes;
+    };
 
-    inline void set_flags(const std::string &str);
+    static const unsigned CHUNK_BITS = 16;
+    static const unsigned NUM_CHUNKS = 1u << (32 - CHUNK_BITS);
+    static const unsigned NUM_SHARDS = 64;
+    static const unsigned UNKNOWN_TAG = 0x80000000u;
+
+    inline string_hash_t(unsigned hash, unsigned char flags)
+        : m_hash(hash), m_flags(flags) {}
+
+    /** Assigns a hash to str if needed, and returns the hash of str.
+     *  Only the shard which str belongs to is locked.
+     *  @param[out] flags Flags of str. */
+    static unsigned get_hash(const std::string &str, unsigned char *flags);
+
+    /** Returns the entry of given hash without any lock.
+     *  Entries are stored in chunks which are never moved or freed,
+     *  so references to them remain valid while other threads intern strings. */
+    static inline const entry_t* get_entry(unsigned hash);
+
+    /** Returns the entry of given hash, allocating its chunk if needed. */
+    static entry_t* get_writable_entry(unsigned hash);
+
+    /** Returns the hash of the unknown term "_u<idx>",
+     *  writing names of unknown terms up to idx if they have not been written.
+     *  idx must not exceed ms_issued_variable_count. */
+    static unsigned get_unknown_hash(unsigned idx);
+
+    /** Returns the index of unknown term if str is "_u<idx>", otherwise 0. */
+    static unsigned parse_unknown_index(const std::string &str);
+
+    static unsigned char compute_flags(const std::string &str);
+
+    static shard_t ms_shards[NUM_SHARDS];
+    static std::atomic<entry_t*> ms_chunks[NUM_CHUNKS];
+    static std::atomic<unsigned> ms_num_strs;
+    static std::atomic<unsigned> ms_issued_variable_count;
+
+    /** Names of unknown terms whose indices are less than this have been written. */
+    static std::atomic<unsigned> ms_num_unknown_names;
+    static std::mutex ms_mutex_for_unknown_names;
 
     unsigned m_hash;
-    bool m_is_constant, m_is_unknown, m_is_hard_term;
+    unsigned char m_flags;
 
 #ifdef _DEBUG
     std::string m_string;
@@ -156,6 +267,55 @@ typedef string_hash_t term_t;
 typedef std::pair<term_t, term_t> substitution_t;
 
 
+/** An array of terms with fixed capacity, which is stored inline.
+ *  Literals hold their terms with this, so that they can be copied
+ *  without any heap allocation.
+ *  Therefore a literal cannot have more than CAPACITY terms,
+ *  and such a literal in inputs is rejected with phillip_exception_t. */
+class term_array_t
+{
+public:
+    typedef term_t value_type;
+    typedef term_t* iterator;
+    typedef const term_t* const_iterator;
+
+    static const int CAPACITY = 12;
+
+    inline term_array_t() : m_size(0) {}
+    inline term_array_t(const std::vector<term_t> &terms);
+
+    inline size_t size() const { return m_size; }
+    inline bool empty() const { return m_size == 0; }
+    inline void clear() { m_size = 0; }
+
+    /** Appends t to the end.
+     *  Throws phillip_exception_t if this is full. */
+    inline void push_back(const term_t &t);
+
+    /** Returns the i-th term.
+     *  Throws std::out_of_range if i is not less than size(), as std::vector does. */
+    inline term_t& at(size_t i);
+    inline const term_t& at(size_t i) const;
+
+    inline term_t& operator[](size_t i) { return m_terms[i]; }
+    inline const term_t& operator[](size_t i) const { return m_terms[i]; }
+
+    inline term_t& front() { return m_terms[0]; }
+    inline const term_t& front() const { return m_terms[0]; }
+    inline term_t& back() { return m_terms[m_size - 1]; }
+    inline const term_t& back() const { return m_terms[m_size - 1]; }
+
+    inline iterator begin() { return m_terms; }
+    inline iterator end() { return m_terms + m_size; }
+    inline const_iterator begin() const { return m_terms; }
+    inline const_iterator end() const { return m_terms + m_size; }
+
+private:
+    term_t m_terms[CAPACITY];
+    unsigned char m_size;
+};
+
+
 /** A struct of literal. */
 class literal_t
 {
@@ -163,13 +323,16 @@ public:
     static inline std::string get_arity(
         const predicate_t &pred, int term_num, bool is_negated);
 
-    inline literal_t() {}
+    /** Returns the interned arity of given predicate, term-number and negation.
+     *  Each thread caches the results by predicate ids,
+     *  so that only the first call for each arity formats and interns it. */
+    static string_hash_t get_arity_hash(
+        const string_hash_t &pred, int term_num, bool is_negated);
+
+    inline literal_t();
     inline literal_t(const std::string &_pred, bool _truth = true);
     inline literal_t(
-        predicate_t _predicate, const std::vector<term_t> _terms,
-        bool _truth = true);
-    inline literal_t(
-        const std::string &_predicate, const std::vector<term_t> _terms,
+        const std::string &_predicate, const std::vector<term_t> &_terms,
         bool _truth = true);
     inline literal_t(
         const std::string &_predicate,
@@ -191,7 +354,14 @@ public:
     bool operator != (const literal_t &x) const;
 
     inline std::string to_string(bool f_colored = false) const;
-    inline std::string get_arity() const;
+
+    /** Returns the arity of this, which has been interned beforehand. */
+    inline const arity_t& get_arity() const { return m_arity.string(); }
+    inline const string_hash_t& get_arity_hash() const { return m_arity; }
+
+    /** Interns the arity of this.
+     *  Call this after modifying predicate, terms or truth directly. */
+    inline void update_arity();
 
     inline bool is_valid() const;
     inline bool is_equality() const { return predicate == "="; }
@@ -201,14 +371,17 @@ public:
 
     void print(std::string *p_out_str, bool f_colored = false) const;
 
-    static const int MAX_ARGUMENTS_NUM = 12;
+    static const int MAX_ARGUMENTS_NUM = term_array_t::CAPACITY;
 
-    predicate_t predicate;
-    std::vector<term_t> terms;
+    /** The predicate, which is interned. */
+    string_hash_t predicate;
+    term_array_t terms;
     bool truth;
 
 private:
     inline void regularize();
+
+    string_hash_t m_arity;
 };
 
 
@@ -293,6 +466,117 @@ private:
 };
 
 
+/** A read-only view of a whole file.
+ *  The file is mapped into memory with mmap if available,
+ *  otherwise it is loaded into a heap buffer.
+ *  Because the view is immutable, it can be read from many threads
+ *  without any lock. */
+class mapped_file_t
+{
+public:
+    mapped_file_t() : m_data(NULL), m_size(0), m_is_mapped(false) {}
+    ~mapped_file_t() { close(); }
+
+    /** Opens the file and returns whether it succeeded. */
+    bool open(const std::string &filename);
+    void close();
+
+    inline const char* data() const { return m_data; }
+    inline size_t size() const { return m_size; }
+    inline bool is_open() const { return m_data != NULL; }
+
+private:
+    mapped_file_t(const mapped_file_t&);
+    mapped_file_t& operator=(const mapped_file_t&);
+
+    const char *m_data;
+    size_t m_size;
+    bool m_is_mapped;
+};
+
+
+/** A growing buffer to which values are appended as a binary.
+ *  Arrays of plain values are appended by one copy. */
+class binary_writer_t
+{
+public:
+    template <class T> inline void write(const T &value);
+    template <class T> inline void write_array(const std::vector<T> &values);
+    inline void write_varint(unsigned long long value);
+    inline void write_string(const std::string &str);
+
+    inline const char* data() const { return m_buf.empty() ? NULL : &m_buf[0]; }
+    inline size_t size() const { return m_buf.size(); }
+
+private:
+    inline char* extend(size_t n);
+    std::vector<char> m_buf;
+};
+
+
+/** A cursor on a binary written by binary_writer_t.
+ *  Throws phillip_exception_t if reading beyond the end. */
+class binary_reader_t
+{
+public:
+    binary_reader_t(const char *begin, const char *end)
+        : m_ptr(begin), m_end(end) {}
+
+    template <class T> inline void read(T *out);
+    template <class T> inline void read_array(std::vector<T> *out);
+    inline unsigned long long read_varint();
+    inline void read_string(std::string *out);
+    inline void skip(size_t n) { consume(n); }
+
+    inline const char* ptr() const { return m_ptr; }
+    inline bool eof() const { return m_ptr >= m_end; }
+
+private:
+    inline const char* consume(size_t n);
+    const char *m_ptr, *m_end;
+};
+
+
+/** A set of threads which are kept waiting for jobs,
+ *  so that a job does not pay for starting threads every time.
+ *  The thread calling run also works on the job. */
+class thread_pool_t
+{
+public:
+    /** @param num_threads The number of threads including the caller of run. */
+    thread_pool_t(int num_threads);
+    ~thread_pool_t();
+
+    /** Calls f(th, i) for each i in [0, n) and waits for all calls to finish.
+     *  th is the index of the thread calling f, which is less than size().
+     *  If any call throws an exception, the remaining indices are skipped
+     *  and the first exception is rethrown here. */
+    void run(size_t n, const std::function<void(int, size_t)> &f);
+
+    inline int size() const { return static_cast<int>(m_workers.size()) + 1; }
+
+private:
+    thread_pool_t(const thread_pool_t&);
+    thread_pool_t& operator=(const thread_pool_t&);
+
+    void work(int th);
+    void process(int th);
+
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_cv_start, m_cv_finish;
+
+    const std::function<void(int, size_t)> *m_job;
+    size_t m_num_indices;
+    std::atomic<size_t> m_next_index;
+    unsigned long long m_generation; /// Incremented on each run.
+    int m_num_working;
+    bool m_do_stop;
+
+    std::exception_ptr m_exception;
+};
+
+
 class timeout_t
 {
 public:
@@ -338,63 +622,289 @@ private:
 };
 
 
+/** Converts a key of pair-tables into 32 bits.
+ *  The conversion must be injective over the keys in use.
+ *  Keys which are not valid would collide with sentinels of the table,
+ *  so that they cannot be added. */
+template <class Key> struct pair_key_traits_t
+{
+    static inline bool is_valid(const Key &k)
+    { return k >= 0 and static_cast<uint64_t>(k) < UINT32_MAX; }
+
+    static inline uint32_t pack(const Key &k) { return static_cast<uint32_t>(k); }
+    static inline Key unpack(uint32_t k) { return static_cast<Key>(k); }
+};
+
+template <> struct pair_key_traits_t<string_hash_t>
+{
+    static inline bool is_valid(const string_hash_t &k) { return k.get_hash() < UINT32_MAX; }
+    static inline uint32_t pack(const string_hash_t &k) { return k.get_hash(); }
+    static inline string_hash_t unpack(uint32_t k) { return string_hash_t::from_hash(k); }
+};
+
+
+/** An open-addressing hash table whose keys are unordered pairs.
+ *  A pair is sorted and packed into a 64-bit key, and all entries
+ *  are stored in one flat array with linear probing.
+ *  Erased entries are left as tombstones until the next rehash,
+ *  so erasing during an iteration is safe. */
 template <class Key, class Value> class triangular_matrix_t
-: public hash_map<Key, hash_map<Key, Value> >
 {
 public:
+    struct entry_t
+    {
+        uint64_t key;
+        Value value;
+
+        inline Key first() const
+        { return pair_key_traits_t<Key>::unpack(static_cast<uint32_t>(key >> 32)); }
+        inline Key second() const
+        { return pair_key_traits_t<Key>::unpack(static_cast<uint32_t>(key)); }
+    };
+
+    template <class Entry> class iterator_base_t
+    {
+    public:
+        iterator_base_t(Entry *p, Entry *end) : m_ptr(p), m_end(end) { skip(); }
+
+        inline Entry& operator*() const { return *m_ptr; }
+        inline Entry* operator->() const { return m_ptr; }
+        inline iterator_base_t& operator++() { ++m_ptr; skip(); return *this; }
+        inline bool operator==(const iterator_base_t &x) const { return m_ptr == x.m_ptr; }
+        inline bool operator!=(const iterator_base_t &x) const { return m_ptr != x.m_ptr; }
+
+    private:
+        friend class triangular_matrix_t;
+        inline void skip() { while (m_ptr != m_end and m_ptr->key >= DELETED) ++m_ptr; }
+
+        Entry *m_ptr, *m_end;
+    };
+
+    typedef iterator_base_t<entry_t> iterator;
+    typedef iterator_base_t<const entry_t> const_iterator;
+
+    triangular_matrix_t() : m_size(0), m_used(0) {}
+
+    /** Adds the value for the pair unless the pair exists already.
+     *  Throws phillip_exception_t if either key is not valid. */
     inline void insert(Key k1, Key k2, const Value &v)
     {
-        this->regularize_keys(k1, k2);
-        (*this)[k1].insert(std::make_pair(k2, v));
+        entry_t *e = get_or_add(pack_valid(k1, k2));
+        if (e != NULL) e->value = v;
     }
 
-    Value* find(Key k1, Key k2)
+    /** Sets the value for the pair, overwriting the existing one.
+     *  Throws phillip_exception_t if either key is not valid. */
+    inline void assign(Key k1, Key k2, const Value &v)
     {
-        this->regularize_keys(k1, k2);
-
-        auto found1 = this->hash_map<Key, hash_map<Key, Value> >::find(k1);
-        if (found1 == this->end()) return NULL;
+        uint64_t key = pack_valid(k1, k2);
+        entry_t *e = get_or_add(key);
+        if (e == NULL) e = &m_entries[probe(key)];
+        e->value = v;
+    }
 
-        auto found2 = found1->second.find(k2);
-        return (found2 == found1->second.end()) ? NULL : &(found2->second);
+    /** Returns NULL if the pair is not found, including when a key is not valid. */
+    inline Value* find(Key k1, Key k2)
+    {
+        if (m_size == 0 or not is_valid(k1, k2)) return NULL;
+        entry_t &e = m_entries[probe(pack(k1, k2))];
+        return (e.key == EMPTY) ? NULL : &e.value;
     }
 
-    const Value* find(Key k1, Key k2) const
+    inline const Value* find(Key k1, Key k2) const
     {
-        this->regularize_keys(k1, k2);
+        if (m_size == 0 or not is_valid(k1, k2)) return NULL;
+        const entry_t &e = m_entries[probe(pack(k1, k2))];
+        return (e.key == EMPTY) ? NULL : &e.value;
+    }
 
-        auto found1 = this->hash_map<Key, hash_map<Key, Value> >::find(k1);
-        if (found1 == this->end()) return NULL;
+    inline int count(Key k1, Key k2) const { return (find(k1, k2) != NULL) ? 1 : 0; }
 
-        auto found2 = found1->second.find(k2);
-        return (found2 == found1->second.end()) ? NULL : &(found2->second);
+    inline iterator erase(iterator it)
+    {
+        it.m_ptr->key = DELETED;
+        it.m_ptr->value = Value();
+        --m_size;
+        ++it;
+        return it;
     }
 
+    inline size_t size() const { return m_size; }
+    inline bool empty() const { return m_size == 0; }
+    inline void clear() { m_entries.clear(); m_size = m_used = 0; }
+
+    inline iterator begin() { return iterator(data(), data() + m_entries.size()); }
+    inline iterator end() { return iterator(data() + m_entries.size(), data() + m_entries.size()); }
+    inline const_iterator begin() const { return const_iterator(data(), data() + m_entries.size()); }
+    inline const_iterator end() const { return const_iterator(data() + m_entries.size(), data() + m_entries.size()); }
+
 protected:
-    inline void regularize_keys(Key &k1, Key &k2) const { if (k1 > k2) std::swap(k1, k2); }
+    static const uint64_t EMPTY = ~static_cast<uint64_t>(0);
+    static const uint64_t DELETED = EMPTY - 1;
+
+    static inline bool is_valid(const Key &k1, const Key &k2)
+    {
+        return pair_key_traits_t<Key>::is_valid(k1) and pair_key_traits_t<Key>::is_valid(k2);
+    }
+
+    static inline uint64_t pack_valid(Key k1, Key k2)
+    {
+        if (not is_valid(k1, k2))
+            throw phillip_exception_t("Invalid key of a pair-table.");
+        return pack(k1, k2);
+    }
+
+    static inline uint64_t pack(Key k1, Key k2)
+    {
+        if (k1 > k2) std::swap(k1, k2);
+        return (static_cast<uint64_t>(pair_key_traits_t<Key>::pack(k1)) << 32)
+            | pair_key_traits_t<Key>::pack(k2);
+    }
+
+    static inline size_t slot_of(uint64_t key)
+    {
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdULL;
+        key ^= key >> 33;
+        return static_cast<size_t>(key);
+    }
+
+    inline entry_t* data() { return m_entries.empty() ? NULL : &m_entries[0]; }
+    inline const entry_t* data() const { return m_entries.empty() ? NULL : &m_entries[0]; }
+
+    /** Returns the slot of the key, or the empty slot where probing stopped. */
+    inline size_t probe(uint64_t key) const
+    {
+        const size_t mask = m_entries.size() - 1;
+        for (size_t i = slot_of(key) & mask;; i = (i + 1) & mask)
+        if (m_entries[i].key == key or m_entries[i].key == EMPTY)
+            return i;
+    }
+
+    /** Returns the new entry for the key, or NULL if the key exists already. */
+    entry_t* get_or_add(uint64_t key)
+    {
+        if ((m_used + 1) * 4 > m_entries.size() * 3)
+            rehash((m_size + 1) * 2 > m_entries.size() ? std::max<size_t>(16, m_entries.size() * 2) : m_entries.size());
+
+        const size_t mask = m_entries.size() - 1;
+        entry_t *tomb = NULL;
+
+        for (size_t i = slot_of(key) & mask;; i = (i + 1) & mask)
+        {
+            entry_t &e = m_entries[i];
+            if (e.key == key) return NULL;
+            if (e.key == DELETED and tomb == NULL) tomb = &e;
+            if (e.key == EMPTY)
+            {
+                if (tomb == NULL) { tomb = &e; ++m_used; }
+                tomb->key = key;
+                ++m_size;
+                return tomb;
+            }
+        }
+    }
+
+    void rehash(size_t capacity)
+    {
+        std::vector<entry_t> old(capacity);
+        old.swap(m_entries);
+        for (auto &e : m_entries) e.key = EMPTY;
+
+        const size_t mask = capacity - 1;
+        for (auto &e : old)
+        if (e.key < DELETED)
+        {
+            size_t i = slot_of(e.key) & mask;
+            while (m_entries[i].key != EMPTY) i = (i + 1) & mask;
+            m_entries[i] = e;
+        }
+        m_used = m_size;
+    }
+
+    std::vector<entry_t> m_entries;
+    size_t m_size; /// The number of entries.
+    size_t m_used; /// The number of entries and tombstones.
+};
+
+
+/** A set of unordered pairs on the flat table of triangular_matrix_t. */
+template <class T> class pair_set_t : public triangular_matrix_t<T, bool>
+{
+public:
+    inline void insert(T x, T y) { triangular_matrix_t<T, bool>::insert(x, y, true); }
 };
 
 
-template <class T> class pair_set_t : public hash_map<T, hash_set<T> >
+/** A monotone priority-queue with radix buckets.
+ *  Keys must be pushed in non-decreasing order of the popped keys,
+ *  as in Dijkstra's algorithm. Non-negative floats can be used as keys
+ *  via float_to_key, because their bit patterns keep the order. */
+template <class T> class radix_heap_t
 {
 public:
-    inline void insert(T x, T y)
+    radix_heap_t() : m_size(0), m_last(0) {}
+
+    static inline uint32_t float_to_key(float f)
     {
-        this->regularize(x, y);
-        (*this)[x].insert(y);
+        uint32_t k;
+        std::memcpy(&k, &f, sizeof(uint32_t));
+        return k;
     }
 
-    inline int count(T x, T y) const
+    inline void push(uint32_t key, const T &value)
     {
-        this->regularize(x, y);
-        auto found1 = this->find(x);
-        if (found1 == this->end()) return 0;
-        auto found2 = found1->second.find(y);
-        return (found2 == found1->second.end()) ? 0 : 1;
+        m_buckets[bucket_of(key)].push_back(std::make_pair(key, value));
+        ++m_size;
     }
 
-protected:
-    inline void regularize(T &x, T &y) const { if (x > y) std::swap(x, y); }
+    /** Removes the element with the minimum key and returns it. */
+    inline std::pair<uint32_t, T> pop()
+    {
+        if (m_buckets[0].empty())
+        {
+            int i(1);
+            while (m_buckets[i].empty()) ++i;
+
+            std::vector<std::pair<uint32_t, T> > &b = m_buckets[i];
+            uint32_t min_key = b.front().first;
+            for (auto it = b.begin(); it != b.end(); ++it)
+                if (it->first < min_key) min_key = it->first;
+
+            m_last = min_key;
+            for (auto it = b.begin(); it != b.end(); ++it)
+                m_buckets[bucket_of(it->first)].push_back(*it);
+            b.clear();
+        }
+
+        std::pair<uint32_t, T> out = m_buckets[0].back();
+        m_buckets[0].pop_back();
+        --m_size;
+        return out;
+    }
+
+    inline bool empty() const { return m_size == 0; }
+    inline size_t size() const { return m_size; }
+
+    inline void clear()
+    {
+        for (int i = 0; i < 33; ++i) m_buckets[i].clear();
+        m_size = 0;
+        m_last = 0;
+    }
+
+private:
+    inline int bucket_of(uint32_t key) const
+    {
+        uint32_t x = key ^ m_last;
+        int n(0);
+        while (x != 0) { x >>= 1; ++n; }
+        return n;
+    }
+
+    std::vector<std::pair<uint32_t, T> > m_buckets[33];
+    size_t m_size;
+    uint32_t m_last;
 };
 
 
@@ -495,10 +1005,15 @@ inline size_t num_to_binary(const int num, char *out);
 inline size_t bool_to_binary(const bool _bool, char *out);
 template <class T> inline size_t to_binary(const T &value, char *out);
 
+/** Writes an unsigned integer in LEB128 format, which takes 1 byte
+ *  per 7 bits, and returns size of binary. */
+inline size_t varint_to_binary(unsigned long long value, char *out);
+
 inline size_t binary_to_string(const char *bin, std::string *out);
 inline size_t binary_to_num(const char *bin, int *out);
 inline size_t binary_to_bool(const char *bin, bool *out);
 template <class T> inline size_t binary_to(const char *bin, T *out);
+inline size_t binary_to_varint(const char *bin, unsigned long long *out);
 
 /** Returns joined string.
  *  If USE_STREAM is true, uses ostringstream to join. */
@@ -10,99 +10,99 @@ namespace phil
 {
 
 
-inline string_hash_t::string_hash_t()
-: m_hash(0)
-{}
-
-
-inline string_hash_t::string_hash_t(const string_hash_t& h)
-: m_hash(h.m_hash)
+inline string_hash_t string_hash_t::from_hash(unsigned hash)
 {
-    set_flags(string());
+    const entry_t *e = get_entry(hash);
+    string_hash_t out(hash, (e == NULL) ? 0 : e->flags);
 #ifdef _DEBUG
-    m_string = h.string();
+    out.m_string = out.string();
 #endif
+    return out;
 }
 
 
+inline string_hash_t::string_hash_t()
+: m_hash(0), m_flags(0)
+{}
+
+
 inline string_hash_t::string_hash_t( const std::string &s )
-    : m_hash(get_hash(s))
+    : m_hash(get_hash(s, &m_flags))
 {
-    set_flags(s);
 #ifdef _DEBUG
     m_string = s;
 #endif
 }
 
 
-inline string_hash_t string_hash_t::get_unknown_hash()
+inline term_array_t::term_array_t(const std::vector<term_t> &terms)
+    : m_size(0)
 {
-    std::lock_guard<std::mutex> lock(ms_mutex_unknown);
-
-    char buffer[128];
-    _sprintf(buffer, "_u%d", ++ms_issued_variable_count);
-    return string_hash_t(std::string(buffer));
+    for (const auto &t : terms)
+        push_back(t);
 }
 
 
-inline void string_hash_t::reset_unknown_hash_count()
+inline void term_array_t::push_back(const term_t &t)
 {
-    std::lock_guard<std::mutex> lock(ms_mutex_unknown);
-    ms_issued_variable_count = 0;
+    if (m_size >= CAPACITY)
+        throw phillip_exception_t(util::format(
+        "A literal cannot have more than %d terms.", CAPACITY));
+
+    m_terms[m_size++] = t;
 }
 
 
-inline unsigned string_hash_t::get_hash(std::string str)
+inline term_t& term_array_t::at(size_t i)
 {
-    std::lock_guard<std::mutex> lock(ms_mutex_hash);
+    if (i >= m_size)
+        throw std::out_of_range("term_array_t::at");
+    return m_terms[i];
+}
 
-    hash_map<std::string, unsigned>::iterator it = ms_hashier.find(str);
-    if (it != ms_hashier.end())
-        return it->second;
-    else
-    {
-        ms_strs.push_back(str);
-        unsigned idx(ms_strs.size() - 1);
-        ms_hashier[str] = idx;
-        return idx;
-    }
+
+inline const term_t& term_array_t::at(size_t i) const
+{
+    if (i >= m_size)
+        throw std::out_of_range("term_array_t::at");
+    return m_terms[i];
 }
 
 
-inline const std::string& string_hash_t::string() const
+inline void string_hash_t::reset_unknown_hash_count()
 {
-    std::lock_guard<std::mutex> lock(ms_mutex_hash);
-    return ms_strs.at(m_hash);
+    ms_issued_variable_count = 0;
 }
 
 
-inline string_hash_t::operator const std::string& () const
+inline const string_hash_t::entry_t* string_hash_t::get_entry(unsigned hash)
 {
-    std::lock_guard<std::mutex> lock(ms_mutex_hash);
-    return ms_strs.at(m_hash);
+    const entry_t *chunk =
+        ms_chunks[hash >> CHUNK_BITS].load(std::memory_order_acquire);
+    return (chunk == NULL) ? NULL : chunk + (hash & ((1u << CHUNK_BITS) - 1));
 }
 
 
-inline string_hash_t& string_hash_t::operator = (const std::string &s)
+inline const std::string& string_hash_t::string() const
 {
-    m_hash = get_hash(s);
-    set_flags(s);
+    static const std::string empty;
+    const entry_t *e = get_entry(m_hash);
+    return (e == NULL) ? empty : e->str;
+}
 
-#ifdef _DEBUG
-    m_string = s;
-#endif
 
-    return *this;
+inline string_hash_t::operator const std::string& () const
+{
+    return string();
 }
 
 
-inline string_hash_t& string_hash_t::operator = (const string_hash_t &h)
+inline string_hash_t& string_hash_t::operator = (const std::string &s)
 {
-    m_hash = h.m_hash;
-    set_flags(string());
+    m_hash = get_hash(s, &m_flags);
 
 #ifdef _DEBUG
-    m_string = h.string();
+    m_string = s;
 #endif
 
     return *this;
@@ -123,7 +123,7 @@ inline bool string_hash_t::operator < (const string_hash_t &x) const
 
 inline bool string_hash_t::operator == (const char *s) const
 {
-    return m_hash == ms_hashier.at(s);
+    return string() == s;
 }
 
 
@@ -145,29 +145,6 @@ inline bool string_hash_t::operator != (const string_hash_t &h) const
 }
 
 
-inline void string_hash_t::set_flags(const std::string &str)
-{
-    assert(not str.empty());
-    if (not str.empty())
-    {
-        m_is_constant = std::isupper(str.at(0));
-        m_is_unknown = (str.size() < 2) ? false :
-            (str.at(0) == '_' and str.at(1) == 'u');
-#ifdef DISABLE_HARD_TERM
-        m_is_hard_term = false;
-#else        
-        m_is_hard_term = str.empty() ? false : (str.front() == '*');
-#endif
-    }
-    else
-    {
-        m_is_constant = false;
-        m_is_unknown = false;
-        m_is_hard_term = false;
-    }
-}
-
-
 inline std::string literal_t::get_arity(
     const predicate_t &pred, int term_num, bool is_negated)
 {
@@ -177,21 +154,24 @@ inline std::string literal_t::get_arity(
 }
 
 
-inline literal_t::literal_t( const std::string &_pred, bool _truth )
-    : predicate(_pred), truth(_truth) {}
-    
-
-inline literal_t::literal_t(
-    predicate_t _pred, const std::vector<term_t> _terms, bool _truth )
-    : predicate(_pred), terms(_terms), truth(_truth)
+inline literal_t::literal_t()
+    : truth(true)
 {
-    regularize();
+    static const string_hash_t arity(get_arity("", 0, false));
+    m_arity = arity;
 }
 
 
+inline literal_t::literal_t( const std::string &_pred, bool _truth )
+    : predicate(_pred), truth(_truth)
+{
+    update_arity();
+}
+    
+
 inline literal_t::literal_t(
     const std::string &_pred,
-    const std::vector<term_t> _terms, bool _truth )
+    const std::vector<term_t> &_terms, bool _truth )
     : predicate(_pred), terms(_terms), truth(_truth)
 {
     regularize();
@@ -240,15 +220,15 @@ inline std::string literal_t::to_string( bool f_colored ) const
 }
 
 
-inline std::string literal_t::get_arity() const
+inline void literal_t::update_arity()
 {
-    return get_arity(predicate, terms.size(), not truth);
+    m_arity = get_arity_hash(predicate, terms.size(), not truth);
 }
 
 
 inline bool literal_t::is_valid() const
 {
-    return not terms.empty() and not predicate.empty();
+    return not terms.empty() and predicate != string_hash_t();
 }
 
 
@@ -257,6 +237,8 @@ inline void literal_t::regularize()
     if (is_equality())
         if (terms.at(0) > terms.at(1))
             std::swap(terms[0], terms[1]);
+
+    update_arity();
 }
 
 
@@ -276,6 +258,97 @@ inline bool timeout_t::do_time_out(const std::chrono::system_clock::time_point &
 }
 
 
+inline char* binary_writer_t::extend(size_t n)
+{
+    size_t size = m_buf.size();
+    m_buf.resize(size + n);
+    return &m_buf[size];
+}
+
+
+template <class T> inline void binary_writer_t::write(const T &value)
+{
+    std::memcpy(extend(sizeof(T)), &value, sizeof(T));
+}
+
+
+template <class T> inline void binary_writer_t::write_array(const std::vector<T> &values)
+{
+    write_varint(values.size());
+    if (not values.empty())
+        std::memcpy(extend(sizeof(T)* values.size()), &values[0], sizeof(T)* values.size());
+}
+
+
+inline void binary_writer_t::write_varint(unsigned long long value)
+{
+    char buf[10];
+    size_t n = varint_to_binary(value, buf);
+    std::memcpy(extend(n), buf, n);
+}
+
+
+inline void binary_writer_t::write_string(const std::string &str)
+{
+    write_varint(str.size());
+    if (not str.empty())
+        std::memcpy(extend(str.size()), str.c_str(), str.size());
+}
+
+
+inline const char* binary_reader_t::consume(size_t n)
+{
+    if (static_cast<size_t>(m_end - m_ptr) < n)
+        throw phillip_exception_t("Unexpected end of binary.");
+
+    const char *out = m_ptr;
+    m_ptr += n;
+    return out;
+}
+
+
+template <class T> inline void binary_reader_t::read(T *out)
+{
+    std::memcpy(out, consume(sizeof(T)), sizeof(T));
+}
+
+
+template <class T> inline void binary_reader_t::read_array(std::vector<T> *out)
+{
+    size_t n = static_cast<size_t>(read_varint());
+    if (n > static_cast<size_t>(m_end - m_ptr) / sizeof(T))
+        throw phillip_exception_t("Unexpected end of binary.");
+
+    out->resize(n);
+    if (n > 0)
+        std::memcpy(&(*out)[0], consume(sizeof(T)* n), sizeof(T)* n);
+}
+
+
+inline unsigned long long binary_reader_t::read_varint()
+{
+    unsigned long long out(0);
+    int shift(0);
+    unsigned char c;
+
+    do
+    {
+        c = static_cast<unsigned char>(*consume(1));
+        out |= static_cast<unsigned long long>(c & 0x7f) << shift;
+        shift += 7;
+    } while ((c & 0x80) and shift < 64);
+
+    return out;
+}
+
+
+inline void binary_reader_t::read_string(std::string *out)
+{
+    size_t n = static_cast<size_t>(read_varint());
+    out->assign(consume(n), n);
+}
+
+
 
 inline void cdb_data_t::put(
     const void *key, size_t ksize, const void *value, size_t vsize)
@@ -484,6 +557,19 @@ template <class T> inline size_t to_binary(const T &value, char *out)
 }
 
 
+inline size_t varint_to_binary(unsigned long long value, char *out)
+{
+    size_t n(0);
+    while (value >= 0x80)
+    {
+        out[n++] = static_cast<char>((value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+    out[n++] = static_cast<char>(value);
+    return n;
+}
+
+
 inline size_t binary_to_string(const char *bin, std::string *out)
 {
     size_t n(0);
@@ -528,6 +614,24 @@ template <class T> inline size_t binary_to(const char *bin, T *out)
 }
 
 
+inline size_t binary_to_varint(const char *bin, unsigned long long *out)
+{
+    size_t n(0);
+    int shift(0);
+    unsigned char c;
+
+    *out = 0;
+    do
+    {
+        c = static_cast<unsigned char>(bin[n++]);
+        *out |= static_cast<unsigned long long>(c & 0x7f) << shift;
+        shift += 7;
+    } while (c & 0x80);
+
+    return n;
+}
+
+
 template <class It> std::string join(
     const It &s_begin, const It &s_end, const std::string &delimiter)
 {
@@ -147,8 +147,8 @@ double costed_converter_t::basic_cost_provider_t::edge_cost(
 
     if (edge.is_chain_edge())
     {
-        lf::axiom_t axiom(base->get_axiom(edge.axiom_id()));
-        if (not axiom.func.scan_parameter("%lf", &cost))
+        auto axiom = base->get_cached_axiom(edge.axiom_id());
+        if (not axiom->scan_parameter("%lf", &cost))
             cost = m_default_axiom_cost;            
     }
     else if (edge.is_unify_edge())
@@ -115,7 +115,7 @@ ilp::ilp_problem_t* weighted_converter_t::execute() const
     {
         for (int depth = 1; not do_time_out(begin); ++depth)
         {
-            const hash_set<pg::node_idx_t>
+            const std::vector<pg::node_idx_t>
             *nodes = graph->search_nodes_with_depth(depth);
             if (nodes == NULL) break;
 
@@ -194,13 +194,13 @@ ilp::ilp_problem_t* weighted_converter_t::execute() const
             cons.add_term(costvar, 1.0);
 
             hash_set<pg::edge_idx_t> edges;
-            const hash_set<pg::hypernode_idx_t> *hns =
+            const std::vector<pg::hypernode_idx_t> *hns =
             graph->search_hypernodes_with_node(n_idx);
 
             if (hns != NULL)
             for (auto hn : (*hns))
             {
-                const hash_set<pg::edge_idx_t>
+                const std::vector<pg::edge_idx_t>
                     *es = graph->search_edges_with_hypernode(hn);
                 if (es == NULL) continue;
 
@@ -325,24 +325,19 @@ std::vector<double> weighted_converter_t::basic_weight_provider_t::operator()(
 
     if (edge.is_chain_edge())
     {
-        lf::axiom_t axiom(base->get_axiom(edge.axiom_id()));
-        lf::logical_function_t branch =
-            axiom.func.branch(edge.type() == pg::EDGE_HYPOTHESIZE ? 0 : 1);
+        auto axiom = base->get_cached_axiom(edge.axiom_id());
+        bool is_lhs = (edge.type() == pg::EDGE_HYPOTHESIZE);
+        size_t num = is_lhs ? axiom->lhs().size() : axiom->rhs().size();
 
-        if (weights.size() == 1 and branch.is_operator(lf::OPR_LITERAL))
+        for (size_t i = 0; i < weights.size() and i < num; ++i)
         {
-            if (branch.param2double(&weights[0]))
+            const std::string &param =
+                is_lhs ? axiom->lhs_param(i) : axiom->rhs_param(i);
+
+            if (lf::param2double(param, &weights[i]))
                 do_use_default = false;
-        }
-        else
-        {
-            for (int i = 0; i < weights.size(); ++i)
-            {
-                if (branch.branch(i).param2double(&weights[i]))
-                    do_use_default = false;
-                else
-                    weights[i] = 0.0;
-            }
+            else
+                weights[i] = 0.0;
         }
     }
 
@@ -363,7 +363,8 @@ void ilp_problem_t::add_constraints_to_forbid_looping_unification(
 
     pg::node_idx_t idx_explains = (from[0] == idx_explained) ? from[1] : from[0];
     hash_set<pg::node_idx_t> descendants;
-    hash_set<pg::node_idx_t> ancestors(m_graph->node(idx_explained).ancestors());
+    const pg::node_set_t &ancs = m_graph->node(idx_explained).ancestors();
+    hash_set<pg::node_idx_t> ancestors(ancs.begin(), ancs.end());
 
     m_graph->enumerate_descendant_nodes(idx_explains, &descendants);
     descendants.insert(idx_explains);
@@ -530,14 +531,14 @@ bool ilp_problem_t::add_constraints_of_transitive_unification(
 
 void ilp_problem_t::add_constraints_of_transitive_unifications()
 {
-    std::list< const hash_set<term_t>* >
+    std::list< const std::vector<term_t>* >
         clusters = m_graph->enumerate_variable_clusters();
 
     for( auto cl = clusters.begin(); cl != clusters.end(); ++cl )
     {
         if( (*cl)->size() <= 2 ) continue;
 
-        std::vector<term_t> terms( (*cl)->begin(), (*cl)->end() );
+        const std::vector<term_t> &terms = (**cl);
         for( size_t i = 2; i < terms.size(); ++i )
         for( size_t j = 1; j < i;            ++j )
         for( size_t k = 0; k < j;            ++k )
@@ -755,17 +756,13 @@ size_t ilp_problem_t::add_constrains_of_exclusive_chains(
 template<class T> variable_idx_t
     ilp_problem_t::find_variable_with_hypernode_unordered(T begin, T end) const
 {
-    const hash_set<pg::hypernode_idx_t> *hns =
+    std::vector<pg::hypernode_idx_t> hns =
         m_graph->find_hypernode_with_unordered_nodes(begin, end);
-    if (hns == NULL)
-        return -1;
-    else
+
+    for (auto it = hns.begin(); it != hns.end(); ++it)
     {
-        for (auto it = hns->begin(); it != hns->end(); ++it)
-        {
-            variable_idx_t i = find_variable_with_hypernode(*it);
-            if (i >= 0) return i;
-        }
+        variable_idx_t i = find_variable_with_hypernode(*it);
+        if (i >= 0) return i;
     }
     return -1;
 }
@@ -999,7 +996,7 @@ void ilp_problem_t::_print_explanations_in_solution(
         bool is_backward = (edge.type() == pg::EDGE_HYPOTHESIZE);
         std::string s_from(util::join(hn_from.begin(), hn_from.end(), ","));
         std::string s_to(util::join(hn_to.begin(), hn_to.end(), ","));
-        std::string axiom_name = base->get_axiom(edge.axiom_id()).name;
+        std::string axiom_name = base->get_cached_axiom(edge.axiom_id())->name;
         std::string gaps = util::join_f(
             m_graph->get_gaps_on_edge(*it),
             [](const std::pair<arity_t, arity_t> &p){return p.first + ":" + p.second; }, ",");
@@ -1153,7 +1150,7 @@ void ilp_solution_t::enumerate_unified_terms_sets(std::list<hash_set<term_t> > *
         if (v >= 0)
         if (variable_is_active(v))
         {
-            const std::vector<term_t> &unified = n.literal().terms;
+            const term_array_t &unified = n.literal().terms;
             auto it_set = out->begin();
 
             for (; it_set != out->end(); ++it_set)
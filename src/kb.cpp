@@ -3,9 +3,12 @@
 #include <iomanip>
 #include <cassert>
 #include <cstring>
+#include <cmath>
 #include <climits>
+#include <limits>
 #include <algorithm>
 #include <thread>
+#include <atomic>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
@@ -104,13 +107,182 @@ bool unification_postponement_t::do_postpone(
 }
 
 
+axiom_cache_t::axiom_cache_t(size_t capacity)
+    : m_num_hits(0), m_num_misses(0)
+{
+    set_capacity(capacity);
+}
+
+
+axiom_cache_t::axiom_ptr_t axiom_cache_t::find(axiom_id_t id) const
+{
+    if (m_capacity == 0) return axiom_ptr_t();
+
+    shard_t &sh = shard(id);
+    std::lock_guard<std::mutex> lock(sh.mutex);
+    auto found = sh.entries.find(id);
+
+    if (found == sh.entries.end())
+    {
+        ++m_num_misses;
+        return axiom_ptr_t();
+    }
+
+    // MOVE THE ENTRY TO THE FRONT AS THE MOST RECENTLY USED.
+    sh.order.splice(sh.order.begin(), sh.order, found->second.second);
+    ++m_num_hits;
+
+    return found->second.first;
+}
+
+
+void axiom_cache_t::insert(axiom_id_t id, const axiom_ptr_t &ptr)
+{
+    if (m_capacity == 0) return;
+
+    shard_t &sh = shard(id);
+    std::lock_guard<std::mutex> lock(sh.mutex);
+
+    // ANOTHER THREAD MAY HAVE DECODED THE SAME AXIOM IN THE MEANTIME.
+    if (sh.entries.count(id) > 0) return;
+
+    while (sh.entries.size() >= m_capacity_per_shard)
+    {
+        sh.entries.erase(sh.order.back());
+        sh.order.pop_back();
+    }
+
+    sh.order.push_front(id);
+    sh.entries[id] = std::make_pair(ptr, sh.order.begin());
+}
+
+
+void axiom_cache_t::clear()
+{
+    for (size_t i = 0; i < NUM_SHARDS; ++i)
+    {
+        std::lock_guard<std::mutex> lock(m_shards[i].mutex);
+        m_shards[i].entries.clear();
+        m_shards[i].order.clear();
+    }
+}
+
+
+void axiom_cache_t::set_capacity(size_t capacity)
+{
+    clear();
+    m_capacity = capacity;
+    m_capacity_per_shard = (capacity + NUM_SHARDS - 1) / NUM_SHARDS;
+}
+
+
+distance_cache_t::distance_cache_t(size_t max_bytes)
+    : m_num_hits(0), m_num_misses(0)
+{
+    set_max_bytes(max_bytes);
+}
+
+
+bool distance_cache_t::find(arity_id_t a1, arity_id_t a2, float *out) const
+{
+    if (m_max_bytes == 0) return false;
+
+    key_t key = pack(a1, a2);
+    shard_t &sh = shard(key);
+    std::lock_guard<std::mutex> lock(sh.mutex);
+
+    auto found = sh.recent.find(key);
+    if (found != sh.recent.end())
+    {
+        *out = found->second;
+        ++m_num_hits;
+        return true;
+    }
+
+    found = sh.old.find(key);
+    if (found != sh.old.end())
+    {
+        // AN ENTRY USED AGAIN IS MOVED TO THE NEWER GENERATION.
+        *out = found->second;
+        sh.old.erase(found);
+        put(&sh, key, *out);
+        ++m_num_hits;
+        return true;
+    }
+
+    ++m_num_misses;
+    return false;
+}
+
+
+void distance_cache_t::insert(arity_id_t a1, arity_id_t a2, float dist) const
+{
+    if (m_max_bytes == 0) return;
+
+    key_t key = pack(a1, a2);
+    shard_t &sh = shard(key);
+    std::lock_guard<std::mutex> lock(sh.mutex);
+
+    if (sh.recent.count(key) == 0)
+        put(&sh, key, dist);
+}
+
+
+void distance_cache_t::put(shard_t *sh, key_t key, float dist) const
+{
+    if (sh->recent.size() >= m_capacity_per_generation)
+    {
+        sh->old.clear();
+        sh->old.swap(sh->recent);
+    }
+
+    sh->recent[key] = dist;
+}
+
+
+void distance_cache_t::clear()
+{
+    for (size_t i = 0; i < NUM_SHARDS; ++i)
+    {
+        std::lock_guard<std::mutex> lock(m_shards[i].mutex);
+        m_shards[i].recent.clear();
+        m_shards[i].old.clear();
+    }
+}
+
+
+void distance_cache_t::set_max_bytes(size_t max_bytes)
+{
+    clear();
+    m_max_bytes = max_bytes;
+    m_capacity_per_generation = std::max<size_t>(
+        max_bytes / (ENTRY_BYTES * NUM_SHARDS * 2), 1);
+}
+
+
+size_t distance_cache_t::size() const
+{
+    size_t out(0);
+
+    for (size_t i = 0; i < NUM_SHARDS; ++i)
+    {
+        std::lock_guard<std::mutex> lock(m_shards[i].mutex);
+        out += m_shards[i].recent.size() + m_shards[i].old.size();
+    }
+
+    return out;
+}
+
+
 const int BUFFER_SIZE = 512 * 512;
 std::unique_ptr<knowledge_base_t, util::deleter_t<knowledge_base_t> > knowledge_base_t::ms_instance;
 std::string knowledge_base_t::ms_filename = "kb";
 float knowledge_base_t::ms_max_distance = -1.0f;
 int knowledge_base_t::ms_thread_num_for_rm = 1;
 bool knowledge_base_t::ms_do_disable_stop_word = false;
-std::mutex knowledge_base_t::ms_mutex_for_cache;
+reachable_matrix_format_e knowledge_base_t::ms_rm_format = RM_FORMAT_PLAIN;
+size_t knowledge_base_t::ms_axiom_cache_size = 0;
+size_t knowledge_base_t::ms_distance_cache_bytes = 0;
 std::mutex knowledge_base_t::ms_mutex_for_rm;
 
 
@@ -127,7 +299,9 @@ knowledge_base_t* knowledge_base_t::instance()
 
 void knowledge_base_t::setup(
     std::string filename, float max_distance,
-    int thread_num_for_rm, bool do_disable_stop_word)
+    int thread_num_for_rm, bool do_disable_stop_word,
+    reachable_matrix_format_e rm_format,
+    size_t axiom_cache_size, size_t distance_cache_bytes)
 {
     if (ms_instance != NULL)
         ms_instance.reset(NULL);
@@ -136,6 +310,9 @@ void knowledge_base_t::setup(
     ms_max_distance = max_distance;
     ms_thread_num_for_rm = thread_num_for_rm;
     ms_do_disable_stop_word = do_disable_stop_word;
+    ms_rm_format = rm_format;
+    ms_axiom_cache_size = axiom_cache_size;
+    ms_distance_cache_bytes = distance_cache_bytes;
 
     if (ms_thread_num_for_rm < 0) ms_thread_num_for_rm = 1;
 }
@@ -144,15 +321,21 @@ void knowledge_base_t::setup(
 knowledge_base_t::knowledge_base_t(const std::string &filename)
     : m_state(STATE_NULL),
       m_filename(filename), m_version(KB_VERSION_1), 
+      m_is_appending(false), m_has_delta(false),
       m_cdb_rhs(filename + ".rhs.cdb"),
       m_cdb_lhs(filename + ".lhs.cdb"),
       m_cdb_axiom_group(filename + ".group.cdb"),
       m_cdb_arg_set(filename + ".args.cdb"),
       m_cdb_arity_patterns(filename + ".pattern.cdb"),
       m_cdb_pattern_to_ids(filename + ".search.cdb"),
+      m_arity_patterns(filename + ".pattern.dat"),
       m_axioms(filename),
       m_arity_db(filename + ".arity.dat"),
-      m_rm(filename + ".rm.dat")
+      m_rm(filename + ".rm.dat"),
+      m_axiom_cache(ms_axiom_cache_size),
+      m_delta(filename + ".delta"),
+      m_num_base_arities(0),
+      m_distance_cache(ms_distance_cache_bytes)
 {
     m_distance_provider = { NULL, "" };
     m_category_table = { NULL, "" };
@@ -194,11 +377,94 @@ void knowledge_base_t::prepare_compile()
         m_cdb_pattern_to_ids.prepare_compile();
         m_category_table.instance->prepare_compile(this);
 
+        // THE DELTA SEGMENT OF THE PREVIOUS KB IS NO LONGER VALID.
+        m_delta.remove();
+        m_is_appending = false;
+        m_has_delta = false;
+
         m_state = STATE_COMPILE;
     }
 }
 
 
+void knowledge_base_t::prepare_append()
+{
+    if (m_state != STATE_NULL)
+        finalize();
+
+    read_config();
+    m_arity_db.read();
+    m_num_base_arities = m_arity_db.arities().size();
+
+    m_axioms.prepare_query();
+    m_cdb_rhs.prepare_query();
+    m_cdb_lhs.prepare_query();
+    m_cdb_axiom_group.prepare_query();
+    m_cdb_arg_set.prepare_query();
+    m_cdb_arity_patterns.prepare_query();
+    m_cdb_pattern_to_ids.prepare_query();
+    m_arity_patterns.prepare_query();
+    m_category_table.instance->prepare_append(this);
+
+    // READ THE PREVIOUS DELTA SEGMENT, WHICH IS REWRITTEN TOGETHER WITH NEW AXIOMS.
+    std::list<lf::axiom_t> axioms;
+    m_previous_delta_rows.clear();
+
+    if (m_has_delta)
+    {
+        m_delta.prepare_query();
+
+        for (axiom_id_t i = 0; i < m_delta.axioms.num_axioms(); ++i)
+            axioms.push_back(m_delta.axioms.get(i));
+
+        for (size_t i = 0; i < m_num_base_arities; ++i)
+        if (m_delta.rm.has_row(i))
+            m_delta.rm.get_row(i, &m_previous_delta_rows[i]);
+
+        size_t value_size;
+        const char *value = (const char*)
+            m_delta.cdb_arg_set.get("#sets", 5, &value_size);
+
+        if (value != NULL)
+        {
+            size_t size(0), num_sets(0);
+            size += util::binary_to<size_t>(value + size, &num_sets);
+
+            for (size_t i = 0; i < num_sets; ++i)
+            {
+                size_t num_args(0);
+                size += util::binary_to<size_t>(value + size, &num_args);
+                m_argument_sets.push_back(hash_set<std::string>());
+
+                for (size_t j = 0; j < num_args; ++j)
+                {
+                    std::string arg;
+                    size += util::binary_to_string(value + size, &arg);
+                    m_argument_sets.back().insert(arg);
+                }
+            }
+        }
+
+        m_delta.finalize();
+    }
+
+    m_delta.prepare_compile();
+    m_is_appending = true;
+    m_has_delta = false;
+    m_state = STATE_COMPILE;
+
+    IF_VERBOSE_2(util::format(
+        "  appending to KB with %d axioms and %lu previously appended axioms",
+        m_axioms.num_axioms(), static_cast<unsigned long>(axioms.size())));
+
+    for (const auto &ax : axioms)
+        insert_implication(ax.func, ax.name);
+
+    // ROWS AFFECTED BY THE PREVIOUS AXIOMS ARE IN m_previous_delta_rows.
+    m_appended_arities.clear();
+}
+
+
 void knowledge_base_t::prepare_query()
 {
     if (m_distance_provider.instance == NULL)
@@ -226,9 +492,13 @@ void knowledge_base_t::prepare_query()
         m_cdb_arg_set.prepare_query();
         m_cdb_arity_patterns.prepare_query();
         m_cdb_pattern_to_ids.prepare_query();
+        m_arity_patterns.prepare_query();
         m_rm.prepare_query();
         m_category_table.instance->prepare_query(this);
 
+        if (m_has_delta)
+            m_delta.prepare_query();
+
         m_state = STATE_QUERY;
     }
 }
@@ -268,8 +538,8 @@ void knowledge_base_t::finalize()
 
         extend_inconsistency();
 
-        insert_cdb(m_rhs_to_axioms, &m_cdb_rhs);
-        insert_cdb(m_lhs_to_axioms, &m_cdb_lhs);
+        insert_cdb(m_rhs_to_axioms, m_is_appending ? &m_delta.cdb_rhs : &m_cdb_rhs);
+        insert_cdb(m_lhs_to_axioms, m_is_appending ? &m_delta.cdb_lhs : &m_cdb_lhs);
         insert_axiom_group_to_cdb();
         insert_argument_set_to_cdb();
 
@@ -290,6 +560,11 @@ void knowledge_base_t::finalize()
             
             fout << "Reachability Matrix:" << std::endl;
             m_rm.prepare_query();
+            if (m_is_appending)
+            {
+                m_delta.rm.prepare_query();
+                m_has_delta = true;
+            }
 
             fout << std::setw(30) << std::right << "" << " | ";
             for (auto arity : m_arity_db.arities())
@@ -304,7 +579,7 @@ void knowledge_base_t::finalize()
                 for (auto a2 : m_arity_db.arities())
                 {
                     arity_id_t idx2 = search_arity_id(a2);
-                    float dist = m_rm.get(idx1, idx2);
+                    float dist = _get_distance(idx1, idx2);
                     fout << std::setw(a2.length()) << (int)dist << " | ";
                 }
                 fout << std::endl;
@@ -312,8 +587,31 @@ void knowledge_base_t::finalize()
         }
 
         m_arity_db.clear();
+        m_appended_arities.clear();
+        m_previous_delta_rows.clear();
+    }
+
+    m_is_appending = false;
+    m_has_delta = false;
+
+    if (state == STATE_QUERY and m_axiom_cache.capacity() > 0)
+    {
+        IF_VERBOSE_3(util::format(
+            "  axiom-cache: %llu hits, %llu misses",
+            m_axiom_cache.num_hits(), m_axiom_cache.num_misses()));
+    }
+    if (state == STATE_QUERY and m_distance_cache.max_bytes() > 0)
+    {
+        IF_VERBOSE_3(util::format(
+            "  distance-cache: %llu hits, %llu misses, %lu entries",
+            m_distance_cache.num_hits(), m_distance_cache.num_misses(),
+            static_cast<unsigned long>(m_distance_cache.size())));
     }
 
+    // AXIOM-IDS AND DISTANCES ARE NOT VALID AFTER THE KB IS REWRITTEN.
+    m_axiom_cache.clear();
+    m_distance_cache.clear();
+
     m_axioms.finalize();
     m_cdb_rhs.finalize();
     m_cdb_lhs.finalize();
@@ -321,7 +619,9 @@ void knowledge_base_t::finalize()
     m_cdb_arg_set.finalize();
     m_cdb_arity_patterns.finalize();
     m_cdb_pattern_to_ids.finalize();
+    m_arity_patterns.finalize();
     m_rm.finalize();
+    m_delta.finalize();
     m_category_table.instance->finalize();
 }
 
@@ -334,6 +634,7 @@ void knowledge_base_t::write_config() const
     char version(NUM_OF_KB_VERSION_TYPES - 1); // LATEST VERSION
     char num_dp = m_distance_provider.key.length();
     char num_ct = m_category_table.key.length();
+    char has_delta(m_is_appending ? 1 : 0);
 
     if (not fo)
         throw phillip_exception_t(
@@ -348,6 +649,8 @@ void knowledge_base_t::write_config() const
     fo.write(&num_ct, sizeof(char));
     fo.write(m_category_table.key.c_str(), m_category_table.key.length());
 
+    fo.write(&has_delta, sizeof(char));
+
     fo.close();
 }
 
@@ -356,7 +659,7 @@ void knowledge_base_t::read_config()
 {
     std::string filename(m_filename + ".conf");
     std::ifstream fi(filename.c_str(), std::ios::in | std::ios::binary);
-    char version, num;
+    char version, num, has_delta(0);
     char key[256];
 
     if (not fi)
@@ -390,13 +693,17 @@ void knowledge_base_t::read_config()
     key[num] = '\0';
     set_category_table(key);
 
+    fi.read(&has_delta, sizeof(char));
+    m_has_delta = (has_delta != 0);
+
     fi.close();
 
 }
 
 
 axiom_id_t knowledge_base_t::insert_implication(
-    const lf::logical_function_t &func, const std::string &name)
+    const lf::logical_function_t &func, const std::string &name,
+    const std::vector<char> *bin)
 {
     if (m_state == STATE_COMPILE)
     {
@@ -415,14 +722,18 @@ axiom_id_t knowledge_base_t::insert_implication(
         func.enumerate_literal_branches(&branches);
         for (auto br : branches)
             if (not br->literal().is_equality())
-                m_arity_db.add(br->literal().get_arity());
+            {
+                arity_id_t arity_id = m_arity_db.add(br->literal().get_arity());
+                if (m_is_appending)
+                    m_appended_arities.insert(arity_id);
+            }
 
         // IF func IS CATEGORICAL KNOWLEDGE, IT IS INSERTED TO CATEGORY-TABLE.
         if (m_category_table.instance->insert(func))
             return INVALID_AXIOM_ID;
 
-        axiom_id_t id = m_axioms.num_axioms();
-        m_axioms.put(name, func);
+        axiom_id_t id = num_of_axioms();
+        (m_is_appending ? m_delta.axioms : m_axioms).put(name, func, bin);
 
         // REGISTER AXIOMS'S GROUPS
         auto spl = util::split(name, "#");
@@ -540,7 +851,7 @@ void knowledge_base_t::insert_argument_set(const lf::logical_function_t &f)
     else
     {
         hash_set<std::string> *pivot = NULL;
-        const std::vector<term_t> &terms(f.literal().terms);
+        const term_array_t &terms(f.literal().terms);
         hash_set<std::string> args(terms.begin(), terms.end());
 
         for (auto it_set = m_argument_sets.begin(); it_set != m_argument_sets.end();)
@@ -580,11 +891,29 @@ void knowledge_base_t::assert_stop_word(const arity_t &arity)
 }
 
 
+axiom_cache_t::axiom_ptr_t knowledge_base_t::get_cached_axiom(axiom_id_t id) const
+{
+    axiom_cache_t::axiom_ptr_t out = m_axiom_cache.find(id);
+
+    if (not out)
+    {
+        out = std::make_shared<const lf::axiom_view_t>(get_axiom_view(id));
+
+        if (id >= 0 and id < num_of_axioms())
+            m_axiom_cache.insert(id, out);
+    }
+
+    return out;
+}
+
+
 hash_set<axiom_id_t> knowledge_base_t::search_axiom_group(axiom_id_t id) const
 {
     std::string key = util::format("#%lu", id);
+    const util::cdb_data_t &dat =
+        (id < m_axioms.num_axioms()) ? m_cdb_axiom_group : m_delta.cdb_axiom_group;
 
-    if (not m_cdb_axiom_group.is_readable())
+    if (not dat.is_readable())
     {
         util::print_warning("kb-search: Kb-state is invalid.");
         return hash_set<axiom_id_t>();
@@ -592,7 +921,7 @@ hash_set<axiom_id_t> knowledge_base_t::search_axiom_group(axiom_id_t id) const
 
     size_t value_size;
     const char *value = (const char*)
-        m_cdb_axiom_group.get(key.c_str(), key.length(), &value_size);
+        dat.get(key.c_str(), key.length(), &value_size);
 
     if (value == NULL) return hash_set<axiom_id_t>(id);
 
@@ -607,6 +936,13 @@ hash_set<axiom_id_t> knowledge_base_t::search_axiom_group(axiom_id_t id) const
 
         auto ids = search_id_list(grp, &m_cdb_axiom_group);
         out.insert(ids.begin(), ids.end());
+
+        // A GROUP CAN HAVE AXIOMS IN BOTH OF THE BASE AND THE DELTA.
+        if (m_has_delta)
+        {
+            ids = search_id_list(grp, &m_delta.cdb_axiom_group);
+            out.insert(ids.begin(), ids.end());
+        }
     }
 
     return out;
@@ -623,14 +959,22 @@ search_argument_set_id(const std::string &arity, int term_idx) const
 
     std::string key = util::format("%s/%d", arity.c_str(), term_idx);
     size_t value_size;
-    const argument_set_id_t *value = (const argument_set_id_t*)
+    const argument_set_id_t *value = NULL;
+
+    if (m_has_delta)
+        value = (const argument_set_id_t*)
+        m_delta.cdb_arg_set.get(key.c_str(), key.length(), &value_size);
+
+    if (value == NULL)
+        value = (const argument_set_id_t*)
         m_cdb_arg_set.get(key.c_str(), key.length(), &value_size);
 
     return (value == NULL) ? 0 : (*value);
 }
 
 
-void knowledge_base_t::search_arity_patterns(arity_id_t arity, std::list<arity_pattern_t> *out) const
+void knowledge_base_t::search_arity_patterns(
+    arity_id_t arity, std::vector<arity_pattern_id_t> *out) const
 {
     if (not m_cdb_arity_patterns.is_readable())
     {
@@ -638,24 +982,33 @@ void knowledge_base_t::search_arity_patterns(arity_id_t arity, std::list<arity_p
         return;
     }
 
-    size_t value_size;
-    const char *value = (const char*)
-        m_cdb_arity_patterns.get(&arity, sizeof(arity_id_t), &value_size);
-
-    if (value != NULL)
+    // PATTERNS IN THE DELTA MAY ALSO BE IN THE BASE.
+    // THE CALLER IS EXPECTED TO REMOVE THE DUPLICATES.
+    for (int i = 0; i < (m_has_delta ? 2 : 1); ++i)
     {
-        size_t num_query, read_size(0);
-        read_size += util::binary_to<size_t>(value, &num_query);
-        out->assign(num_query, arity_pattern_t());
+        const util::cdb_data_t &dat =
+            (i == 0) ? m_cdb_arity_patterns : m_delta.cdb_arity_patterns;
+        size_t value_size;
+        const char *value = (const char*)
+            dat.get(&arity, sizeof(arity_id_t), &value_size);
 
-        for (auto it = out->begin(); it != out->end(); ++it)
-            read_size += binary_to_query(value + read_size, &(*it));
+        if (value != NULL)
+        {
+            size_t num_id;
+            util::binary_to<size_t>(value, &num_id);
+
+            size_t n = out->size();
+            out->resize(n + num_id);
+            std::memcpy(
+                &(*out)[n], value + sizeof(size_t),
+                sizeof(arity_pattern_id_t) * num_id);
+        }
     }
 }
 
 
 void knowledge_base_t::search_axioms_with_arity_pattern(
-    const arity_pattern_t &query,
+    arity_pattern_id_t id,
     std::list<std::pair<axiom_id_t, bool> > *out) const
 {
     if (not m_cdb_pattern_to_ids.is_readable())
@@ -664,25 +1017,30 @@ void knowledge_base_t::search_axioms_with_arity_pattern(
         return;
     }
 
-    std::vector<char> key;
-    query_to_binary(query, &key);
-
-    size_t value_size;
-    const char *value = (const char*)
-        m_cdb_pattern_to_ids.get(&key[0], key.size(), &value_size);
+    out->clear();
 
-    if (value != NULL)
+    // IDS IN THE DELTA FOLLOW IDS IN THE BASE, SO THE OUTPUT IS KEPT SORTED.
+    for (int i = 0; i < (m_has_delta ? 2 : 1); ++i)
     {
-        size_t size(0), num_id(0);
-        size += util::binary_to<size_t>(value + size, &num_id);
-        out->assign(num_id, std::pair<axiom_id_t, bool>());
+        const util::cdb_data_t &dat =
+            (i == 0) ? m_cdb_pattern_to_ids : m_delta.cdb_pattern_to_ids;
+        size_t value_size;
+        const char *value = (const char*)
+            dat.get(&id, sizeof(arity_pattern_id_t), &value_size);
 
-        for (auto it = out->begin(); it != out->end(); ++it)
+        if (value != NULL)
         {
-            char flag;
-            size += util::binary_to<axiom_id_t>(value + size, &(it->first));
-            size += util::binary_to<char>(value + size, &flag);
-            it->second = (flag != 0x00);
+            size_t size(0), num_id(0);
+            size += util::binary_to<size_t>(value + size, &num_id);
+
+            for (size_t j = 0; j < num_id; ++j)
+            {
+                axiom_id_t ax;
+                char flag;
+                size += util::binary_to<axiom_id_t>(value + size, &ax);
+                size += util::binary_to<char>(value + size, &flag);
+                out->push_back(std::make_pair(ax, (flag != 0x00)));
+            }
         }
     }
 }
@@ -723,28 +1081,67 @@ void knowledge_base_t::set_category_table(
 float knowledge_base_t::get_distance(
     const std::string &arity1, const std::string &arity2 ) const
 {
-    arity_id_t get1 = search_arity_id(arity1);
-    arity_id_t get2 = search_arity_id(arity2);
-    if (get1 == INVALID_ARITY_ID or get2 == INVALID_ARITY_ID) return -1.0f;
+    return get_distance(search_arity_id(arity1), search_arity_id(arity2));
+}
+
+
+float knowledge_base_t::get_distance(arity_id_t arity1, arity_id_t arity2) const
+{
+    if (arity1 == INVALID_ARITY_ID or arity2 == INVALID_ARITY_ID) return -1.0f;
+
+    float dist;
+    if (m_distance_cache.find(arity1, arity2, &dist))
+        return dist;
+
+    dist = _get_distance(arity1, arity2);
+    m_distance_cache.insert(arity1, arity2, dist);
+    return dist;
+}
+
+
+void knowledge_base_t::prewarm_distance_cache(const hash_set<arity_id_t> &arities) const
+{
+    if (m_distance_cache.max_bytes() == 0) return;
+
+    IF_VERBOSE_2(util::format(
+        "Prewarming the distance-cache for %lu arities...",
+        static_cast<unsigned long>(arities.size())));
 
-    std::lock_guard<std::mutex> lock(ms_mutex_for_cache);
-    auto found1 = m_cache_distance.find(get1);
-    if (found1 != m_cache_distance.end())
+    for (auto a : arities)
     {
-        auto found2 = found1->second.find(get2);
-        if (found2 != found1->second.end())
-            return found2->second;
+        if (a == INVALID_ARITY_ID) continue;
+
+        // A ROW HAS THE DISTANCES TO THE ARITIES WHOSE IDS ARE NOT LESS THAN a.
+        hash_map<size_t, float> row;
+        if (m_has_delta and m_delta.rm.has_row(a))
+            m_delta.rm.get_row(a, &row);
+        else
+            m_rm.get_row(a, &row);
+
+        for (auto p : row)
+            m_distance_cache.insert(a, p.first, p.second);
+
+        // THE REST ARE IN THE ROWS OF OTHER ARITIES.
+        for (auto b : arities)
+        if (b != INVALID_ARITY_ID and b < a)
+            m_distance_cache.insert(a, b, _get_distance(b, a));
     }
+}
 
-    float dist(m_rm.get(get1, get2));
-    m_cache_distance[get1][get2] = dist;
-    return dist;
+
+float knowledge_base_t::_get_distance(arity_id_t a1, arity_id_t a2) const
+{
+    // A ROW IN THE DELTA OVERRIDES THE CORRESPONDING ROW IN THE BASE.
+    if (m_has_delta and m_delta.rm.has_row(std::min(a1, a2)))
+        return m_delta.rm.get(a1, a2);
+    else
+        return m_rm.get(a1, a2);
 }
 
 
 void knowledge_base_t::insert_axiom_group_to_cdb()
 {
-    util::cdb_data_t &dat(m_cdb_axiom_group);
+    util::cdb_data_t &dat(m_is_appending ? m_delta.cdb_axiom_group : m_cdb_axiom_group);
     const hash_map<std::string, hash_set<axiom_id_t> >& map(m_group_to_axioms);
     hash_map<axiom_id_t, hash_set<std::string> > axiom_to_group;
 
@@ -789,18 +1186,74 @@ void knowledge_base_t::insert_axiom_group_to_cdb()
 
 void knowledge_base_t::insert_argument_set_to_cdb()
 {
-    IF_VERBOSE_1("starts writing " + m_cdb_arg_set.filename() + "...");
+    util::cdb_data_t &dat(m_is_appending ? m_delta.cdb_arg_set : m_cdb_arg_set);
+    argument_set_id_t num_base(0);
+
+    IF_VERBOSE_1("starts writing " + dat.filename() + "...");
     IF_VERBOSE_4(util::format("  # of arg-sets = %d", m_argument_sets.size()));
 
+    if (m_is_appending)
+    {
+        size_t value_size;
+        const argument_set_id_t *value = (const argument_set_id_t*)
+            m_cdb_arg_set.get("#", 1, &value_size);
+
+        if (value != NULL)
+            num_base = (*value);
+        else
+            util::print_warning(
+            "The number of argument sets in the base KB is unknown. "
+            "Please re-compile it.");
+    }
+
     unsigned processed(0);
     for (auto args = m_argument_sets.begin(); args != m_argument_sets.end(); ++args)
     {
-        argument_set_id_t id = (++processed);
+        argument_set_id_t id(INVALID_ARGUMENT_SET_ID);
+
+        /* ON APPENDING, A SET WHICH SHARES ARGUMENTS WITH A SET IN THE BASE
+         * TAKES OVER ITS ID. SETS IN THE BASE ARE NEVER MERGED. */
+        if (m_is_appending)
+        for (auto arg = args->begin(); arg != args->end() and id == INVALID_ARGUMENT_SET_ID; ++arg)
+        {
+            size_t value_size;
+            const argument_set_id_t *value = (const argument_set_id_t*)
+                m_cdb_arg_set.get(arg->c_str(), arg->length(), &value_size);
+            if (value != NULL) id = (*value);
+        }
+
+        if (id == INVALID_ARGUMENT_SET_ID)
+            id = num_base + (++processed);
+
         for (auto arg = args->begin(); arg != args->end(); ++arg)
-            m_cdb_arg_set.put(arg->c_str(), arg->length(), &id, sizeof(argument_set_id_t));
+            dat.put(arg->c_str(), arg->length(), &id, sizeof(argument_set_id_t));
+    }
+
+    argument_set_id_t num = num_base + processed;
+    dat.put("#", 1, &num, sizeof(argument_set_id_t));
+
+    // ARGUMENT SETS IN THE DELTA ARE KEPT TO BE MERGED ON THE NEXT APPENDING.
+    if (m_is_appending)
+    {
+        std::vector<char> value(sizeof(size_t), '\0');
+        size_t size = util::to_binary<size_t>(m_argument_sets.size(), &value[0]);
+
+        for (const auto &args : m_argument_sets)
+        {
+            value.resize(size + sizeof(size_t));
+            size += util::to_binary<size_t>(args.size(), &value[size]);
+
+            for (const auto &arg : args)
+            {
+                value.resize(size + sizeof(unsigned char) + arg.length());
+                size += util::string_to_binary(arg, &value[size]);
+            }
+        }
+
+        dat.put("#sets", 5, &value[0], size);
     }
 
-    IF_VERBOSE_1("completed writing " + m_cdb_arg_set.filename() + ".");
+    IF_VERBOSE_1("completed writing " + dat.filename() + ".");
 }
 
 
@@ -819,6 +1272,8 @@ void knowledge_base_t::set_stop_words()
 
     IF_VERBOSE_1("Setting stop-words...");
     m_axioms.prepare_query();
+    if (m_is_appending)
+        m_delta.axioms.prepare_query();
 
     typedef std::pair <std::string, char> term_pos_t;
     hash_map<arity_t, hash_set<term_idx_t> > candidates;
@@ -882,9 +1337,9 @@ void knowledge_base_t::set_stop_words()
         }
     };
 
-    for (axiom_id_t id = 0; id < m_axioms.num_axioms(); ++id)
+    for (axiom_id_t id = 0; id < num_of_axioms(); ++id)
     {
-        lf::axiom_t ax = m_axioms.get(id);
+        lf::axiom_t ax = get_axiom(id);
 
         if (ax.func.is_operator(lf::OPR_IMPLICATION))
             proc(ax, true);
@@ -896,7 +1351,7 @@ void knowledge_base_t::set_stop_words()
 
         if (id % 10 == 0 and phillip_main_t::verbose() >= VERBOSE_1)
         {
-            float progress = (float)(id)* 100.0f / (float)m_axioms.num_axioms();
+            float progress = (float)(id)* 100.0f / (float)num_of_axioms();
             std::cerr << util::format("processed %d axioms [%.4f%%]\r", id, progress);
         }
     }
@@ -956,7 +1411,7 @@ void knowledge_base_t::set_stop_words()
     {
         double coef =
             (m_asserted_stop_words.count(it->first) > 0) ? 100.0 :
-            100.0 * ((double)counts.at(it->first) - 0.9) / m_axioms.num_axioms();
+            100.0 * ((double)counts.at(it->first) - 0.9) / num_of_axioms();
         ilp::variable_t var(it->first, coef);
         it->second = prob.add_variable(var);
     }
@@ -1025,7 +1480,20 @@ void knowledge_base_t::create_query_map()
     m_cdb_rhs.prepare_query();
     m_cdb_lhs.prepare_query();
 
-    std::map<arity_id_t, std::set<arity_pattern_t> > arity_to_queries;
+    /* ON APPENDING, ONLY PATTERNS OF THE AXIOMS IN THE DELTA ARE WRITTEN.
+     * THEY ARE MERGED WITH THOSE IN THE BASE ON QUERY. */
+    util::cdb_data_t &cdb_patterns(
+        m_is_appending ? m_delta.cdb_arity_patterns : m_cdb_arity_patterns);
+    util::cdb_data_t &cdb_ids(
+        m_is_appending ? m_delta.cdb_pattern_to_ids : m_cdb_pattern_to_ids);
+    arity_pattern_table_t &table(
+        m_is_appending ? m_delta.arity_patterns : m_arity_patterns);
+    axiom_id_t first = m_is_appending ? m_axioms.num_axioms() : 0;
+
+    if (m_is_appending)
+        m_delta.axioms.prepare_query();
+
+    std::map<arity_id_t, std::set<const arity_pattern_t*> > arity_to_queries;
     std::map<arity_pattern_t, std::set< std::pair<axiom_id_t, bool> > > pattern_to_ids;
 
     auto proc = [this, &pattern_to_ids, &arity_to_queries](
@@ -1065,14 +1533,16 @@ void knowledge_base_t::create_query_map()
         if (category_table()->do_target(branches[i]->literal().get_arity()))
             std::get<2>(query).push_back(i);
 
-        pattern_to_ids[query].insert(std::make_pair(ax.id, is_backward));
+        auto inserted = pattern_to_ids.insert(std::make_pair(
+            query, std::set< std::pair<axiom_id_t, bool> >()));
+        inserted.first->second.insert(std::make_pair(ax.id, is_backward));
 
         for (auto idx : std::get<0>(query))
         if (m_stop_words.count(search_arity(idx)) == 0)
-            arity_to_queries[idx].insert(query);
+            arity_to_queries[idx].insert(&inserted.first->first);
     };
 
-    for (axiom_id_t i = 0; i < m_axioms.num_axioms(); ++i)
+    for (axiom_id_t i = first; i < num_of_axioms(); ++i)
     {
         lf::axiom_t ax = get_axiom(i);
 
@@ -1086,53 +1556,80 @@ void knowledge_base_t::create_query_map()
 
         if (i % 10 == 0 and phillip_main_t::verbose() >= VERBOSE_1)
         {
-            float progress = (float)(i)* 100.0f / (float)m_axioms.num_axioms();
+            float progress = (float)(i - first)* 100.0f / (float)(num_of_axioms() - first);
             std::cerr << util::format("processed %d axioms [%.4f%%]\r", i, progress);
         }
     }
 
-    m_cdb_arity_patterns.prepare_compile();
-    IF_VERBOSE_2("  Writing " + m_cdb_arity_patterns.filename() + "...");
+    /* IDS ARE ASSIGNED TO PATTERNS IN THE ORDER OF THEIR CONTENTS.
+     * ON APPENDING, PATTERNS IN THE BASE KEEP THEIR IDS
+     * AND NEW PATTERNS ARE GIVEN IDS FOLLOWING THEM. */
+    hash_map<const arity_pattern_t*, arity_pattern_id_t> pattern_to_id;
+    std::vector<const arity_pattern_t*> new_patterns;
+    arity_pattern_id_t num_base = m_is_appending ? m_arity_patterns.size() : 0;
 
-    for (auto p : arity_to_queries)
+    for (const auto &p : pattern_to_ids)
     {
-        std::list< std::vector<char> > queries;
-        size_t size_value(0);
+        arity_pattern_id_t id = num_base + new_patterns.size();
 
-        size_value += sizeof(size_t);
-        for (auto q : p.second)
+        if (m_is_appending)
         {
-            std::vector<char> bin;
-            query_to_binary(q, &bin);
-            queries.push_back(bin);
-            size_value += bin.size();
-        }
+            std::vector<arity_pattern_view_t::word_t> words;
+            arity_pattern_view_t::encode(p.first, &words);
+            arity_pattern_view_t view(&words[0]);
 
-        char *value = new char[size_value];
-        size_t size(0);
+            // PATTERNS IN THE BASE ARE SORTED BY THEIR IDS.
+            arity_pattern_id_t lo(0), hi(num_base);
+            while (lo < hi)
+            {
+                arity_pattern_id_t mid = lo + (hi - lo) / 2;
+                if (m_arity_patterns.get(mid) < view) lo = mid + 1;
+                else hi = mid;
+            }
 
-        size += util::to_binary<size_t>(p.second.size(), value);
-        for (auto q : queries)
-        {
-            std::memcpy(value + size, &q[0], q.size());
-            size += q.size();
+            if (lo < num_base and not (view < m_arity_patterns.get(lo)))
+                id = lo;
         }
 
-        assert(size == size_value);
-        m_cdb_arity_patterns.put(
-            (char*)(&p.first), sizeof(arity_id_t), value, size_value);
+        if (id >= num_base)
+            new_patterns.push_back(&p.first);
+        pattern_to_id[&p.first] = id;
+    }
+
+    IF_VERBOSE_2("  Writing " + table.filename() + "...");
+    table.write(new_patterns);
+    IF_VERBOSE_2("  Completed writing " + table.filename() + ".");
+
+    cdb_patterns.prepare_compile();
+    IF_VERBOSE_2("  Writing " + cdb_patterns.filename() + "...");
+
+    for (auto p : arity_to_queries)
+    {
+        std::vector<arity_pattern_id_t> ids;
+        for (auto q : p.second)
+            ids.push_back(pattern_to_id.at(q));
+        std::sort(ids.begin(), ids.end());
+
+        size_t size_value = sizeof(size_t) + sizeof(arity_pattern_id_t) * ids.size();
+        std::vector<char> value(size_value, '\0');
+
+        size_t size = util::to_binary<size_t>(ids.size(), &value[0]);
+        std::memcpy(&value[0] + size, &ids[0], sizeof(arity_pattern_id_t) * ids.size());
+        size += sizeof(arity_pattern_id_t) * ids.size();
 
-        delete[] value;
+        assert(size == size_value);
+        cdb_patterns.put(
+            (char*)(&p.first), sizeof(arity_id_t), &value[0], size_value);
     }
 
-    IF_VERBOSE_2("  Completed writing " + m_cdb_arity_patterns.filename() + ".");
-    m_cdb_pattern_to_ids.prepare_compile();
-    IF_VERBOSE_2("  Writing " + m_cdb_pattern_to_ids.filename() + "...");
+    IF_VERBOSE_2("  Completed writing " + cdb_patterns.filename() + ".");
+    cdb_ids.prepare_compile();
+    IF_VERBOSE_2("  Writing " + cdb_ids.filename() + "...");
 
-    for (auto p : pattern_to_ids)
+    for (const auto &p : pattern_to_ids)
     {
-        std::vector<char> key, val;
-        query_to_binary(p.first, &key);
+        arity_pattern_id_t key = pattern_to_id.at(&p.first);
+        std::vector<char> val;
 
         size_t size_val = sizeof(size_t) + (sizeof(axiom_id_t) + sizeof(char)) * p.second.size();
         val.assign(size_val, '\0');
@@ -1145,11 +1642,11 @@ void knowledge_base_t::create_query_map()
         }
         assert(size == size_val);
 
-        m_cdb_pattern_to_ids.put(&key[0], key.size(), &val[0], val.size());
+        cdb_ids.put((char*)&key, sizeof(arity_pattern_id_t), &val[0], val.size());
     }
 
     IF_VERBOSE_3(util::format("    # of patterns = %d", pattern_to_ids.size()));
-    IF_VERBOSE_2("  Completed writing " + m_cdb_pattern_to_ids.filename() + ".");
+    IF_VERBOSE_2("  Completed writing " + cdb_ids.filename() + ".");
     IF_VERBOSE_1("Completed the arity patterns creation.");
 }
 
@@ -1158,19 +1655,22 @@ void knowledge_base_t::create_reachable_matrix()
 {
     IF_VERBOSE_1("starts to create reachable matrix...");
 
-    size_t processed(0), num_inserted(0);
+    std::atomic<size_t> processed(0), num_inserted(0);
     clock_t clock_past = clock_t();
-    time_t time_start, time_end;
-    time(&time_start);
+    auto time_start = std::chrono::system_clock::now();
 
     m_axioms.prepare_query();
     m_cdb_rhs.prepare_query();
     m_cdb_lhs.prepare_query();
     m_category_table.instance->prepare_query(this);
 
-    m_rm.prepare_compile();
+    if (m_is_appending)
+        m_delta.axioms.prepare_query();
+
+    reachable_matrix_t &rm(m_is_appending ? m_delta.rm : m_rm);
+    rm.prepare_compile(ms_rm_format, get_max_distance());
 
-    IF_VERBOSE_3(util::format("  num of axioms = %d", m_axioms.num_axioms()));
+    IF_VERBOSE_3(util::format("  num of axioms = %d", num_of_axioms()));
     IF_VERBOSE_3(util::format("  num of arities = %d", m_arity_db.arities().size()));
     IF_VERBOSE_3(util::format("  max distance = %.2f", get_max_distance()));
     IF_VERBOSE_3(util::format("  num of parallel threads = %d", ms_thread_num_for_rm));
@@ -1190,73 +1690,187 @@ void knowledge_base_t::create_reachable_matrix()
     
     _create_reachable_matrix_direct(ignored, &base_lhs, &base_rhs, &base_para);
 
+    const reachability_graph_t graph(arities.size(), base_lhs, base_rhs, base_para);
+    base_lhs.clear();
+    base_rhs.clear();
+    base_para.clear();
+
+    /* ON APPENDING, ONLY ROWS WHICH MAY BE CHANGED BY NEW AXIOMS ARE COMPUTED.
+     * THE OTHER ROWS IN THE PREVIOUS DELTA ARE TAKEN OVER AS THEY ARE. */
+    std::vector<arity_id_t> targets;
+
+    if (m_is_appending)
+    {
+        hash_set<arity_id_t> updated;
+        _enumerate_arities_to_update(graph, ignored, &updated);
+        targets.assign(updated.begin(), updated.end());
+        std::sort(targets.begin(), targets.end());
+
+        for (auto it = m_previous_delta_rows.begin(); it != m_previous_delta_rows.end(); ++it)
+        if (updated.count(it->first) == 0)
+            rm.put(it->first, it->second);
+
+        IF_VERBOSE_3(util::format(
+            "  num of rows to update = %lu", static_cast<unsigned long>(targets.size())));
+    }
+    else
+    {
+        targets.reserve(arities.size());
+        for (arity_id_t idx = 0; idx < arities.size(); ++idx)
+            targets.push_back(idx);
+    }
+
     IF_VERBOSE_2("  writing reachable matrix...");
     std::vector<std::thread> worker;
     int num_thread =
-        std::min<int>(arities.size(),
+        std::min<int>(targets.size(),
         std::min<int>(ms_thread_num_for_rm, std::thread::hardware_concurrency()));
+    if (num_thread < 1) num_thread = 1;
+
+    /* EACH THREAD TAKES THE NEXT UNPROCESSED TARGET,
+     * SO THAT A THREAD WHICH HAS DRAWN HUB PREDICATES DOES NOT DELAY OTHERS. */
+    std::atomic<size_t> next_idx(0);
     
     for (int th_id = 0; th_id < num_thread; ++th_id)
     {
         worker.emplace_back(
-            [&](int th_id)
+            [&]()
             {
-                for(arity_id_t idx = th_id; idx < arities.size(); idx += num_thread)
+                reachable_matrix_t::row_buffer_t buf;
+                reachability_search_buffer_t search_buf;
+
+                for (size_t i = next_idx++; i < targets.size(); i = next_idx++)
                 {
+                    arity_id_t idx = targets[i];
                     if (ignored.count(idx) != 0) continue;
                     
                     hash_map<arity_id_t, float> dist;
-                    _create_reachable_matrix_indirect(
-                        idx, base_lhs, base_rhs, base_para, &dist);
-                    m_rm.put(idx, dist);
+                    _create_reachable_matrix_indirect(idx, graph, &search_buf, &dist);
+                    rm.put(idx, dist, &buf);
 
-                    ms_mutex_for_rm.lock();
-                    
                     num_inserted += dist.size();
                     ++processed;
 
-                    clock_t c = clock();
-                    if (c - clock_past > CLOCKS_PER_SEC)
+                    if (phillip_main_t::verbose() >= VERBOSE_1 and
+                        ms_mutex_for_rm.try_lock())
                     {
-                        float progress = (float)(processed)* 100.0f / (float)arities.size();
-                        std::cerr << util::format(
-                            "processed %d tokens [%.4f%%]\r", processed, progress);
-                        std::cerr.flush();
-                        clock_past = c;
+                        clock_t c = clock();
+                        if (c - clock_past > CLOCKS_PER_SEC)
+                        {
+                            float progress =
+                                (float)(processed) * 100.0f / (float)targets.size();
+                            std::cerr << util::format(
+                                "processed %lu tokens [%.4f%%]\r",
+                                static_cast<unsigned long>(processed.load()), progress);
+                            std::cerr.flush();
+                            clock_past = c;
+                        }
+                        ms_mutex_for_rm.unlock();
                     }
-                    
-                    ms_mutex_for_rm.unlock();
                 }
-            }, th_id);
+
+                rm.flush(&buf);
+            });
     }
     for (auto &t : worker) t.join();
     
-    time(&time_end);
-    int proc_time(time_end - time_start); 
+    duration_time_t proc_time = util::duration_time(time_start);
     double coverage(
         num_inserted * 100.0 /
         (double)(arities.size() * arities.size()));
+    double sec = std::max<double>(proc_time, 0.001);
     
     IF_VERBOSE_1("completed computation.");
-    IF_VERBOSE_3(util::format("  process-time = %d", proc_time));
+    IF_VERBOSE_3(util::format("  process-time = %.2f", proc_time));
     IF_VERBOSE_3(util::format("  coverage = %.6lf%%", coverage));
+    IF_VERBOSE_3(util::format(
+        "  throughput = %.1lf rows/s, %.1lf entries/s",
+        processed / sec, num_inserted / sec));
 }
 
 
-void knowledge_base_t::_create_reachable_matrix_direct(
-    const hash_set<arity_id_t> &ignored,
-    hash_map<arity_id_t, hash_map<arity_id_t, float> > *out_lhs,
-    hash_map<arity_id_t, hash_map<arity_id_t, float> > *out_rhs,
-    std::set<std::pair<arity_id_t, arity_id_t> > *out_para)
+void knowledge_base_t::_enumerate_arities_to_update(
+    const reachability_graph_t &graph, const hash_set<arity_id_t> &ignored,
+    hash_set<arity_id_t> *out) const
 {
-    size_t num_processed(0);
-    const std::vector<arity_t> &arities = m_arity_db.arities();
+    /* A ROW CAN BE CHANGED ONLY IF THE ARITY REACHES ANY ARITY IN NEW AXIOMS
+     * WITHIN THE MAX DISTANCE, IN WHICHEVER DIRECTION THE EDGES ARE. */
+    const float INF = std::numeric_limits<float>::infinity();
+    const float max_dist = get_max_distance();
+    std::vector<std::vector<std::pair<uint32_t, float> > > edges(graph.size());
+    std::vector<float> dists(graph.size(), INF);
+    util::radix_heap_t<arity_id_t> heap;
 
-    // SET VALUES IN CATEGORY-TABLE TO REACHABLE-MATRIX
-    for (arity_id_t i = 1; i < arities.size(); ++i)
+    for (arity_id_t i = 0; i < graph.size(); ++i)
     {
-        hash_map<arity_id_t, float> buf;
-        m_category_table.instance->gets(i, &buf);
+        if (not graph.is_node(i)) continue;
+
+        auto add = [&](const std::pair<
+            const reachability_graph_t::edge_t*,
+            const reachability_graph_t::edge_t*> &range)
+        {
+            for (auto e = range.first; e != range.second; ++e)
+            {
+                edges[i].push_back(std::make_pair(e->target, e->dist));
+                edges[e->target].push_back(std::make_pair(i, e->dist));
+            }
+        };
+        add(graph.lhs_edges(i));
+        add(graph.rhs_edges(i));
+    }
+
+    auto push = [&](arity_id_t idx, float dist)
+    {
+        if (dist < dists[idx])
+        {
+            dists[idx] = dist;
+            heap.push(util::radix_heap_t<arity_id_t>::float_to_key(dist), idx);
+        }
+    };
+
+    for (auto idx : m_appended_arities)
+    if (idx < graph.size())
+        push(idx, 0.0f);
+
+    // ARITIES WHICH ARE NEW TO THE BASE HAVE NO ROW IN IT.
+    for (arity_id_t idx = m_num_base_arities; idx < graph.size(); ++idx)
+        push(idx, 0.0f);
+
+    while (not heap.empty())
+    {
+        std::pair<uint32_t, arity_id_t> top = heap.pop();
+        arity_id_t idx = top.second;
+
+        if (util::radix_heap_t<arity_id_t>::float_to_key(dists[idx]) != top.first)
+            continue; // THIS ENTRY IS STALE.
+
+        if (ignored.count(idx) == 0)
+            out->insert(idx);
+
+        for (const auto &e : edges[idx])
+        {
+            float dist = dists[idx] + e.second;
+            if (max_dist < 0.0f or dist <= max_dist)
+                push(e.first, dist);
+        }
+    }
+}
+
+
+void knowledge_base_t::_create_reachable_matrix_direct(
+    const hash_set<arity_id_t> &ignored,
+    hash_map<arity_id_t, hash_map<arity_id_t, float> > *out_lhs,
+    hash_map<arity_id_t, hash_map<arity_id_t, float> > *out_rhs,
+    std::set<std::pair<arity_id_t, arity_id_t> > *out_para)
+{
+    size_t num_processed(0);
+    const std::vector<arity_t> &arities = m_arity_db.arities();
+
+    // SET VALUES IN CATEGORY-TABLE TO REACHABLE-MATRIX
+    for (arity_id_t i = 1; i < arities.size(); ++i)
+    {
+        hash_map<arity_id_t, float> buf;
+        m_category_table.instance->gets(i, &buf);
         
         for (auto p : buf)
         if (p.second >= 0.0f)
@@ -1275,12 +1889,12 @@ void knowledge_base_t::_create_reachable_matrix_direct(
         }
     }
 
-    for (axiom_id_t id = 0; id < m_axioms.num_axioms(); ++id)
+    for (axiom_id_t id = 0; id < num_of_axioms(); ++id)
     {
-        lf::axiom_t axiom = get_axiom(id);
+        lf::axiom_view_t axiom = get_axiom_view(id);
 
-        if (axiom.func.is_operator(lf::OPR_IMPLICATION) or
-            axiom.func.is_operator(lf::OPR_PARAPHRASE))
+        if (axiom.is_operator(lf::OPR_IMPLICATION) or
+            axiom.is_operator(lf::OPR_PARAPHRASE))
         {
             float dist = (*m_distance_provider.instance)(axiom);
 
@@ -1289,23 +1903,18 @@ void knowledge_base_t::_create_reachable_matrix_direct(
                 hash_set<arity_id_t> lhs_ids, rhs_ids;
 
                 {
-                    std::vector<const literal_t*> lhs = axiom.func.get_lhs();
-                    std::vector<const literal_t*> rhs = axiom.func.get_rhs();
-
-                    for (auto it_l = lhs.begin(); it_l != lhs.end(); ++it_l)
+                    for (const literal_t &lit : axiom.lhs())
                     {
-                        std::string arity = (*it_l)->get_arity();
-                        arity_id_t idx = search_arity_id(arity);
+                        arity_id_t idx = search_arity_id(lit);
 
                         if (idx != INVALID_ARITY_ID)
                         if (ignored.count(idx) == 0)
                             lhs_ids.insert(idx);
                     }
 
-                    for (auto it_r = rhs.begin(); it_r != rhs.end(); ++it_r)
+                    for (const literal_t &lit : axiom.rhs())
                     {
-                        std::string arity = (*it_r)->get_arity();
-                        arity_id_t idx = search_arity_id(arity);
+                        arity_id_t idx = search_arity_id(lit);
 
                         if (idx != INVALID_ARITY_ID)
                         if (ignored.count(idx) == 0)
@@ -1339,7 +1948,7 @@ void knowledge_base_t::_create_reachable_matrix_direct(
                     }
                 }
 
-                if (axiom.func.is_operator(lf::OPR_PARAPHRASE))
+                if (axiom.is_operator(lf::OPR_PARAPHRASE))
                 for (auto it_l = lhs_ids.begin(); it_l != lhs_ids.end(); ++it_l)
                 for (auto it_r = rhs_ids.begin(); it_r != rhs_ids.end(); ++it_r)
                     out_para->insert(util::make_sorted_pair(*it_l, *it_r));
@@ -1348,7 +1957,7 @@ void knowledge_base_t::_create_reachable_matrix_direct(
 
         if (++num_processed % 10 == 0 and phillip_main_t::verbose() >= VERBOSE_1)
         {
-            float progress = (float)(num_processed)* 100.0f / (float)m_axioms.num_axioms();
+            float progress = (float)(num_processed)* 100.0f / (float)num_of_axioms();
             std::cerr << util::format("processed %d axioms [%.4f%%]\r", num_processed, progress);
         }
     }    
@@ -1356,83 +1965,134 @@ void knowledge_base_t::_create_reachable_matrix_direct(
 
 
 void knowledge_base_t::_create_reachable_matrix_indirect(
-    arity_id_t target,
-    const hash_map<arity_id_t, hash_map<arity_id_t, float> > &base_lhs,
-    const hash_map<arity_id_t, hash_map<arity_id_t, float> > &base_rhs,
-    const std::set<std::pair<arity_id_t, arity_id_t> > &base_para,
+    arity_id_t target, const reachability_graph_t &graph,
+    reachability_search_buffer_t *buf,
     hash_map<arity_id_t, float> *out) const
 {
-    if (base_lhs.count(target) == 0 or base_rhs.count(target) == 0) return;
+    if (target >= graph.size() or not graph.is_node(target)) return;
+
+    const float INF = std::numeric_limits<float>::infinity();
+    const int CAN_ABDUCTION(2), CAN_DEDUCTION(1);
+    const float max_dist = get_max_distance();
 
-    std::map<std::tuple<arity_id_t, bool, bool>, float> current;
-    std::map<std::tuple<arity_id_t, bool, bool>, float> processed;
+    if (buf->dists.size() != graph.size() * 4)
+        buf->dists.assign(graph.size() * 4, INF);
+    buf->heap.clear();
 
-    current[std::make_tuple(target, true, true)] = 0.0f;
-    processed[std::make_tuple(target, true, true)] = 0.0f;
+    /* BOUNDED DIJKSTRA OVER STATES OF (ARITY, CAN-ABDUCTION, CAN-DEDUCTION). */
+    size_t start = target * 4 + (CAN_ABDUCTION | CAN_DEDUCTION);
+    buf->dists[start] = 0.0f;
+    buf->touched.push_back(start);
+    buf->heap.push(util::radix_heap_t<size_t>::float_to_key(0.0f), start);
     (*out)[target] = 0.0f;
 
-    while (not current.empty())
+    while (not buf->heap.empty())
     {
-        std::map<std::tuple<arity_id_t, bool, bool>, float> next;
+        std::pair<uint32_t, size_t> top = buf->heap.pop();
+        size_t state = top.second;
+        float dist = buf->dists[state];
+
+        if (util::radix_heap_t<size_t>::float_to_key(dist) != top.first)
+            continue; // THIS ENTRY IS STALE.
+
+        arity_id_t idx1 = state / 4;
+        int flags = static_cast<int>(state % 4);
+
         auto _process = [&](
-            arity_id_t idx1, bool can_abduction, bool can_deduction,
-            float dist, bool is_forward)
+            const std::pair<const reachability_graph_t::edge_t*,
+            const reachability_graph_t::edge_t*> &edges, bool is_forward)
         {
-            const hash_map<arity_id_t, hash_map<arity_id_t, float> >
-                &base = (is_forward ? base_lhs : base_rhs);
-            auto found = base.find(idx1);
-
-            if (found != base.end())
-            for (auto it2 = found->second.begin(); it2 != found->second.end(); ++it2)
+            for (auto e = edges.first; e != edges.second; ++e)
             {
-                arity_id_t idx2(it2->first);
-                if (idx1 == idx2) continue;
-
-                bool is_paraphrasal =
-                    (base_para.count(util::make_sorted_pair(idx1, idx2)) > 0);
-                if (not is_paraphrasal and
-                    ((is_forward and not can_deduction) or
-                    (not is_forward and not can_abduction)))
-                    continue;
+                if (e->target == idx1) continue;
 
-                float dist_new(dist + it2->second); // DISTANCE idx1 ~ idx2
-                if (get_max_distance() < 0.0f or dist_new <= get_max_distance())
-                {
-                    std::tuple<arity_id_t, bool, bool> key =
-                        std::make_tuple(idx2, can_abduction, can_deduction);
+                if (not e->is_paraphrasal and
+                    ((is_forward and not (flags & CAN_DEDUCTION)) or
+                    (not is_forward and not (flags & CAN_ABDUCTION))))
+                    continue;
 
-                    // ONCE DONE DEDUCTION, YOU CANNOT DO ABDUCTION!
-                    if (is_forward and not is_paraphrasal) std::get<1>(key) = false;
+                float dist_new(dist + e->dist); // DISTANCE idx1 ~ idx2
+                if (max_dist >= 0.0f and dist_new > max_dist) continue;
 
-                    bool do_add(false);
-                    auto found = processed.find(key);
-                    if (found == processed.end())  do_add = true;
-                    else if (dist_new < found->second) do_add = true;
+                // ONCE DONE DEDUCTION, YOU CANNOT DO ABDUCTION!
+                int flags_new = flags;
+                if (is_forward and not e->is_paraphrasal)
+                    flags_new &= ~CAN_ABDUCTION;
 
-                    if (do_add)
-                    {
-                        next[key] = dist_new;
-                        processed[key] = dist_new;
+                size_t state_new = e->target * 4 + flags_new;
+                float &d = buf->dists[state_new];
 
-                        auto found_out = out->find(idx2);
-                        if (found_out == out->end())           (*out)[idx2] = dist_new;
-                        else if (dist_new < found_out->second) (*out)[idx2] = dist_new;
-                    }
+                if (dist_new < d)
+                {
+                    if (d == INF) buf->touched.push_back(state_new);
+                    d = dist_new;
+                    buf->heap.push(
+                        util::radix_heap_t<size_t>::float_to_key(dist_new), state_new);
+
+                    auto found_out = out->find(e->target);
+                    if (found_out == out->end())           (*out)[e->target] = dist_new;
+                    else if (dist_new < found_out->second) found_out->second = dist_new;
                 }
             }
         };
 
-        for (auto it1 = current.begin(); it1 != current.end(); ++it1)
-        {
-            arity_id_t idx = std::get<0>(it1->first);
-            bool can_abduction = std::get<1>(it1->first);
-            bool can_deduction = std::get<2>(it1->first);
+        _process(graph.rhs_edges(idx1), false);
+        _process(graph.lhs_edges(idx1), true);
+    }
 
-            _process(idx, can_abduction, can_deduction, it1->second, false);
-            _process(idx, can_abduction, can_deduction, it1->second, true);
-        }
+    // RESETS ONLY THE STATES WHICH HAVE BEEN REACHED.
+    for (auto s : buf->touched)
+        buf->dists[s] = INF;
+    buf->touched.clear();
+}
 
-        current = next;
+
+knowledge_base_t::reachability_graph_t::reachability_graph_t(
+    size_t num_arities,
+    const hash_map<arity_id_t, hash_map<arity_id_t, float> > &base_lhs,
+    const hash_map<arity_id_t, hash_map<arity_id_t, float> > &base_rhs,
+    const std::set<std::pair<arity_id_t, arity_id_t> > &base_para)
+    : m_is_node(num_arities, 0)
+{
+    for (arity_id_t i = 0; i < num_arities; ++i)
+    if (base_lhs.count(i) > 0 and base_rhs.count(i) > 0)
+        m_is_node[i] = 1;
+
+    freeze(num_arities, base_lhs, base_para, &m_lhs_offsets, &m_lhs_edges);
+    freeze(num_arities, base_rhs, base_para, &m_rhs_offsets, &m_rhs_edges);
+}
+
+
+void knowledge_base_t::reachability_graph_t::freeze(
+    size_t num_arities,
+    const hash_map<arity_id_t, hash_map<arity_id_t, float> > &base,
+    const std::set<std::pair<arity_id_t, arity_id_t> > &base_para,
+    std::vector<size_t> *offsets, std::vector<edge_t> *edges)
+{
+    offsets->assign(num_arities + 1, 0);
+
+    for (auto it = base.begin(); it != base.end(); ++it)
+    if (it->first < num_arities)
+        (*offsets)[it->first + 1] = it->second.size();
+
+    for (size_t i = 0; i < num_arities; ++i)
+        (*offsets)[i + 1] += (*offsets)[i];
+
+    edges->resize(offsets->back() + 1); // +1 KEEPS &edges[0] VALID.
+
+    for (auto it1 = base.begin(); it1 != base.end(); ++it1)
+    {
+        if (it1->first >= num_arities) continue;
+        size_t i = (*offsets)[it1->first];
+
+        for (auto it2 = it1->second.begin(); it2 != it1->second.end(); ++it2, ++i)
+        {
+            edge_t &e = (*edges)[i];
+            e.target = static_cast<uint32_t>(it2->first);
+            e.dist = it2->second;
+            e.is_paraphrasal =
+                (base_para.count(util::make_sorted_pair(it1->first, it2->first)) > 0);
+        }
     }
 }
 
@@ -1538,9 +2198,10 @@ std::list<axiom_id_t> knowledge_base_t::search_id_list(
 
 std::mutex knowledge_base_t::axioms_database_t::ms_mutex;
 
-knowledge_base_t::axioms_database_t::axioms_database_t(const std::string &filename)
+knowledge_base_t::axioms_database_t::axioms_database_t(
+    const std::string &filename, bool is_delta)
 : m_filename(filename),
-m_fo_idx(NULL), m_fo_dat(NULL), m_fi_idx(NULL), m_fi_dat(NULL),
+m_fo_idx(NULL), m_fo_dat(NULL), m_is_delta(is_delta),
 m_num_compiled_axioms(0), m_num_unnamed_axioms(0)
 {}
 
@@ -1580,13 +2241,20 @@ void knowledge_base_t::axioms_database_t::prepare_query()
     {
         std::lock_guard<std::mutex> lock(ms_mutex);
 
-        m_fi_idx = new std::ifstream(
-            (m_filename + ".index.dat").c_str(), std::ios::binary | std::ios::in);
-        m_fi_dat = new std::ifstream(
-            (m_filename + ".axioms.dat").c_str(), std::ios::binary | std::ios::in);
+        if (not m_mf_idx.open(m_filename + ".index.dat"))
+            throw phillip_exception_t(
+            "Failed to open a database file: " + m_filename + ".index.dat");
+        if (not m_mf_dat.open(m_filename + ".axioms.dat"))
+            throw phillip_exception_t(
+            "Failed to open a database file: " + m_filename + ".axioms.dat");
 
-        m_fi_idx->seekg(-static_cast<int>(sizeof(int)), std::ios_base::end);
-        m_fi_idx->read((char*)&m_num_compiled_axioms, sizeof(int));
+        if (m_mf_idx.size() < sizeof(int))
+            throw phillip_exception_t(
+            "Broken database file: " + m_filename + ".index.dat");
+
+        std::memcpy(
+            &m_num_compiled_axioms,
+            m_mf_idx.data() + m_mf_idx.size() - sizeof(int), sizeof(int));
     }
 }
 
@@ -1608,73 +2276,110 @@ void knowledge_base_t::axioms_database_t::finalize()
         m_fo_dat = NULL;
     }
 
-    if (m_fi_idx != NULL)
-    {
-        delete m_fi_idx;
-        m_fi_idx = NULL;
-    }
-
-    if (m_fi_dat != NULL)
-    {
-        delete m_fi_dat;
-        m_fi_dat = NULL;
-    }
+    m_mf_idx.close();
+    m_mf_dat.close();
 }
 
 
 void knowledge_base_t::axioms_database_t::put(
-    const std::string &name, const lf::logical_function_t &func)
+    const std::string &name, const lf::logical_function_t &func,
+    const std::vector<char> *bin)
 {
     const int SIZE(512 * 512);
     char buffer[SIZE];
+    size_t size(0);
 
     /* AXIOM => BINARY-DATA */
-    size_t size = func.write_binary(buffer);
-    size += util::string_to_binary(
+    // PRE-ENCODED AXIOMS ARE WRITTEN AS THEY ARE, FOLLOWED BY THE NAME IN buffer.
+    if (bin == NULL)
+        size = func.write_binary(buffer);
+    size_t size_name = util::string_to_binary(
         (name.empty() ? get_name_of_unnamed_axiom() : name),
         buffer + size);
-    assert(size < BUFFER_SIZE and size < ULONG_MAX);
+    size_t size_all = size_name + ((bin != NULL) ? bin->size() : size);
+
+    if (size_all >= BUFFER_SIZE)
+        throw phillip_exception_t(
+        "The binary of an axiom is too large: " + name);
 
     /* INSERT AXIOM TO CDB.ID */
-    axiom_size_t _size(static_cast<axiom_size_t>(size));
+    axiom_size_t _size(static_cast<axiom_size_t>(size_all));
     m_fo_idx->write((char*)(&m_writing_pos), sizeof(axiom_pos_t));
     m_fo_idx->write((char*)(&_size), sizeof(axiom_size_t));
 
-    m_fo_dat->write(buffer, size);
+    if (bin != NULL)
+        m_fo_dat->write(bin->data(), bin->size());
+    m_fo_dat->write(buffer, size + size_name);
 
     ++m_num_compiled_axioms;
-    m_writing_pos += size;
+    m_writing_pos += size_all;
 }
 
 
 lf::axiom_t knowledge_base_t::axioms_database_t::get(axiom_id_t id) const
 {
-    std::lock_guard<std::mutex> lock(ms_mutex);
     lf::axiom_t out;
+    const char *bin = find_binary(id);
+
+    if (bin != NULL)
+    {
+        /* DECODE THE AXIOM DIRECTLY FROM THE MAPPED REGION. */
+        out.id = id;
+        size_t _size = out.func.read_binary(bin);
+        _size += util::binary_to_string(bin + _size, &out.name);
+    }
+
+    return out;
+}
+
+
+lf::axiom_view_t knowledge_base_t::axioms_database_t::get_view(axiom_id_t id) const
+{
+    lf::axiom_view_t out;
+    const char *bin = find_binary(id);
 
+    if (bin != NULL)
+    {
+        out.id = id;
+        out.read_binary(bin);
+    }
+
+    return out;
+}
+
+
+const char* knowledge_base_t::axioms_database_t::find_binary(axiom_id_t id) const
+{
     if (not is_readable())
     {
         util::print_warning("kb-search: KB is currently not readable.");
-        return out;
+        return NULL;
     }
 
+    // UNIFICATION EDGES HAVE NEGATIVE AXIOM-IDS.
+    if (id < 0) return NULL;
+
+    const size_t entry_size = sizeof(axiom_pos_t) + sizeof(axiom_size_t);
     axiom_pos_t pos;
     axiom_size_t size;
-    const int SIZE(512 * 512);
-    char buffer[SIZE];
 
-    m_fi_idx->seekg(id * (sizeof(axiom_pos_t)+sizeof(axiom_size_t)));
-    m_fi_idx->read((char*)&pos, sizeof(axiom_pos_t));
-    m_fi_idx->read((char*)&size, sizeof(axiom_size_t));
+    if (static_cast<size_t>(id) >= m_mf_idx.size() / entry_size)
+    {
+        util::print_warning_fmt("kb-search: Invalid axiom-id: %ld", id);
+        return NULL;
+    }
 
-    m_fi_dat->seekg(pos);
-    m_fi_dat->read(buffer, size);
+    const char *entry = m_mf_idx.data() + id * entry_size;
+    std::memcpy(&pos, entry, sizeof(axiom_pos_t));
+    std::memcpy(&size, entry + sizeof(axiom_pos_t), sizeof(axiom_size_t));
 
-    out.id = id;
-    size_t _size = out.func.read_binary(buffer);
-    _size += util::binary_to_string(buffer + _size, &out.name);
+    if (pos + size > m_mf_dat.size())
+    {
+        util::print_warning_fmt("kb-search: Broken axiom data: %ld", id);
+        return NULL;
+    }
 
-    return out;
+    return m_mf_dat.data() + pos;
 }
 
 
@@ -1693,6 +2398,7 @@ void knowledge_base_t::arity_database_t::clear()
 
     m_arity2id.clear();
     m_arity2id[""] = INVALID_ARITY_ID;
+    m_hash2id.clear();
 
     m_unification_postponements.clear();
     m_mutual_exclusions.clear();
@@ -1833,11 +2539,175 @@ void knowledge_base_t::arity_database_t::add_mutual_exclusion(const literal_t &l
 
 
 
+knowledge_base_t::delta_segment_t::delta_segment_t(const std::string &prefix)
+    : prefix(prefix),
+      axioms(prefix, true),
+      cdb_rhs(prefix + ".rhs.cdb"),
+      cdb_lhs(prefix + ".lhs.cdb"),
+      cdb_axiom_group(prefix + ".group.cdb"),
+      cdb_arg_set(prefix + ".args.cdb"),
+      cdb_arity_patterns(prefix + ".pattern.cdb"),
+      cdb_pattern_to_ids(prefix + ".search.cdb"),
+      arity_patterns(prefix + ".pattern.dat"),
+      rm(prefix + ".rm.dat")
+{}
+
+
+void knowledge_base_t::delta_segment_t::prepare_compile()
+{
+    axioms.prepare_compile();
+    cdb_rhs.prepare_compile();
+    cdb_lhs.prepare_compile();
+    cdb_axiom_group.prepare_compile();
+    cdb_arg_set.prepare_compile();
+    cdb_arity_patterns.prepare_compile();
+    cdb_pattern_to_ids.prepare_compile();
+}
+
+
+void knowledge_base_t::delta_segment_t::prepare_query()
+{
+    axioms.prepare_query();
+    cdb_rhs.prepare_query();
+    cdb_lhs.prepare_query();
+    cdb_axiom_group.prepare_query();
+    cdb_arg_set.prepare_query();
+    cdb_arity_patterns.prepare_query();
+    cdb_pattern_to_ids.prepare_query();
+    arity_patterns.prepare_query();
+    rm.prepare_query();
+}
+
+
+void knowledge_base_t::delta_segment_t::finalize()
+{
+    axioms.finalize();
+    cdb_rhs.finalize();
+    cdb_lhs.finalize();
+    cdb_axiom_group.finalize();
+    cdb_arg_set.finalize();
+    cdb_arity_patterns.finalize();
+    cdb_pattern_to_ids.finalize();
+    arity_patterns.finalize();
+    rm.finalize();
+}
+
+
+void knowledge_base_t::delta_segment_t::remove()
+{
+    finalize();
+
+    const util::cdb_data_t *cdbs[] = {
+        &cdb_rhs, &cdb_lhs, &cdb_axiom_group, &cdb_arg_set,
+        &cdb_arity_patterns, &cdb_pattern_to_ids };
+
+    for (auto cdb : cdbs)
+        std::remove(cdb->filename().c_str());
+
+    std::remove((prefix + ".index.dat").c_str());
+    std::remove((prefix + ".axioms.dat").c_str());
+    std::remove((prefix + ".rm.dat").c_str());
+    std::remove(arity_patterns.filename().c_str());
+}
+
+
+knowledge_base_t::arity_pattern_table_t::arity_pattern_table_t(const std::string &filename)
+    : m_filename(filename), m_num_patterns(0), m_offsets(NULL), m_words(NULL)
+{}
+
+
+void knowledge_base_t::arity_pattern_table_t::write(
+    const std::vector<const arity_pattern_t*> &patterns) const
+{
+    std::ofstream fo(
+        m_filename.c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+
+    if (not fo)
+        throw phillip_exception_t("Failed to open a database file: " + m_filename);
+
+    std::vector<arity_pattern_view_t::word_t> words, buf;
+    std::vector<pos_t> offsets;
+    size_t num = patterns.size();
+
+    for (auto p : patterns)
+    {
+        offsets.push_back(words.size());
+        arity_pattern_view_t::encode(*p, &buf);
+        words.insert(words.end(), buf.begin(), buf.end());
+    }
+    offsets.push_back(words.size());
+
+    fo.write((const char*)&num, sizeof(size_t));
+    fo.write((const char*)&offsets[0], sizeof(pos_t) * offsets.size());
+    if (not words.empty())
+        fo.write((const char*)&words[0], sizeof(arity_pattern_view_t::word_t) * words.size());
+}
+
+
+void knowledge_base_t::arity_pattern_table_t::prepare_query()
+{
+    if (m_mf.is_open()) return;
+
+    if (not m_mf.open(m_filename))
+        throw phillip_exception_t(
+        "Failed to open a database file: " + m_filename);
+
+    if (m_mf.size() < sizeof(size_t))
+        throw phillip_exception_t("Broken database file: " + m_filename);
+
+    typedef arity_pattern_view_t::word_t word_t;
+    auto throw_broken = [this]()
+    {
+        finalize();
+        throw phillip_exception_t("Broken database file: " + m_filename);
+    };
+
+    std::memcpy(&m_num_patterns, m_mf.data(), sizeof(size_t));
+
+    // THE COUNT IS CHECKED BEFORE IT IS USED, SO THAT THE OFFSETS DO NOT WRAP.
+    size_t pos = sizeof(size_t);
+    if (m_num_patterns >= (m_mf.size() - pos) / sizeof(pos_t))
+        throw_broken();
+
+    m_offsets = reinterpret_cast<const pos_t*>(m_mf.data() + pos);
+    pos += sizeof(pos_t) * (m_num_patterns + 1);
+    m_words = reinterpret_cast<const word_t*>(m_mf.data() + pos);
+
+    const size_t num_words = (m_mf.size() - pos) / sizeof(word_t);
+
+    // EACH PATTERN MUST FIT IN ITS SPAN OF WORDS, WHICH ARE IN THE FILE.
+    if (m_offsets[0] != 0 or m_offsets[m_num_patterns] > num_words)
+        throw_broken();
+
+    for (size_t i = 0; i < m_num_patterns; ++i)
+    {
+        pos_t begin(m_offsets[i]), end(m_offsets[i + 1]);
+        if (end < begin or end - begin < 3)
+            throw_broken();
+
+        const word_t *w = m_words + begin;
+        if (3ull + w[0] + 4ull * w[1] + w[2] != end - begin)
+            throw_broken();
+    }
+}
+
+
+void knowledge_base_t::arity_pattern_table_t::finalize()
+{
+    m_mf.close();
+    m_num_patterns = 0;
+    m_offsets = NULL;
+    m_words = NULL;
+}
+
+
 std::mutex knowledge_base_t::reachable_matrix_t::ms_mutex;
 
 
 knowledge_base_t::reachable_matrix_t::reachable_matrix_t(const std::string &filename)
-    : m_filename(filename), m_fout(NULL), m_fin(NULL)
+    : m_filename(filename), m_fout(NULL),
+      m_format(RM_FORMAT_PLAIN), m_scale(1.0),
+      m_num_rows(0), m_row_offsets(NULL), m_row_lengths(NULL), m_rows_end(NULL)
 {}
 
 
@@ -1847,7 +2717,8 @@ knowledge_base_t::reachable_matrix_t::~reachable_matrix_t()
 }
 
 
-void knowledge_base_t::reachable_matrix_t::prepare_compile()
+void knowledge_base_t::reachable_matrix_t::prepare_compile(
+    reachable_matrix_format_e format, float max_distance)
 {
     if (is_readable())
         finalize();
@@ -1855,11 +2726,36 @@ void knowledge_base_t::reachable_matrix_t::prepare_compile()
     if (not is_writable())
     {
         std::lock_guard<std::mutex> lock(ms_mutex);
-        pos_t pos;
+        pos_t pos(0);
+
+        m_format = format;
+        m_scale = 1.0;
+
+        if (m_format != RM_FORMAT_PLAIN)
+        {
+            if (max_distance < 0.0f)
+            {
+                util::print_warning(
+                    "The compact reachable-matrix needs kb_max_distance. "
+                    "The plain format is used instead.");
+                m_format = RM_FORMAT_PLAIN;
+            }
+            else
+            {
+                // THE LARGEST POWER OF TWO SUCH THAT max_distance FITS IN THE CODE.
+                double max_code = (m_format == RM_FORMAT_COMPACT8) ? 255.0 : 65535.0;
+                m_scale = 1.0;
+                while (m_scale < 65536.0 and max_distance * m_scale * 2.0 <= max_code)
+                    m_scale *= 2.0;
+                while (m_scale > 1.0 / 65536.0 and max_distance * m_scale > max_code)
+                    m_scale /= 2.0;
+            }
+        }
         
         m_fout = new std::ofstream(
             m_filename.c_str(), std::ios::binary | std::ios::out);
         m_fout->write((const char*)&pos, sizeof(pos_t));
+        m_rows_written.clear();
     }
 }
 
@@ -1873,21 +2769,65 @@ void knowledge_base_t::reachable_matrix_t::prepare_query()
     {
         std::lock_guard<std::mutex> lock(ms_mutex);
         pos_t pos;
-        size_t num, idx;
+        size_t format;
 
-        m_fin = new std::ifstream(
-            m_filename.c_str(), std::ios::binary | std::ios::in);
+        if (not m_mf.open(m_filename))
+            throw phillip_exception_t(
+            "Failed to open a database file: " + m_filename);
 
-        m_fin->read((char*)&pos, sizeof(pos_t));
-        m_fin->seekg(pos, std::ios::beg);
+        if (m_mf.size() < sizeof(pos_t))
+            throw phillip_exception_t("Broken database file: " + m_filename);
 
-        m_fin->read((char*)&num, sizeof(size_t));
-        for (size_t i = 0; i < num; ++i)
+        auto throw_broken = [this]()
         {
-            m_fin->read((char*)&idx, sizeof(idx));
-            m_fin->read((char*)&pos, sizeof(pos_t));
-            m_map_idx_to_pos[idx] = pos;
+            m_mf.close();
+            m_num_rows = 0;
+            throw phillip_exception_t("Broken database file: " + m_filename);
+        };
+
+        // EVERY VALUE READ IS CHECKED, SO THAT A BROKEN FILE CANNOT BREAK MEMORY.
+        const size_t head_size = sizeof(size_t) * 2 + sizeof(double);
+        std::memcpy(&pos, m_mf.data(), sizeof(pos_t));
+        const pos_t index_pos = pos;
+        if (pos < sizeof(pos_t) or pos % sizeof(pos_t) != 0 or
+            pos > m_mf.size() or m_mf.size() - pos < head_size)
+            throw_broken();
+
+        std::memcpy(&m_num_rows, m_mf.data() + pos, sizeof(size_t));
+        pos += sizeof(size_t);
+        std::memcpy(&format, m_mf.data() + pos, sizeof(size_t));
+        pos += sizeof(size_t);
+        std::memcpy(&m_scale, m_mf.data() + pos, sizeof(double));
+        pos += sizeof(double);
+
+        if (format != RM_FORMAT_PLAIN and
+            format != RM_FORMAT_COMPACT8 and format != RM_FORMAT_COMPACT16)
+            throw_broken();
+        m_format = static_cast<reachable_matrix_format_e>(format);
+
+        if (m_num_rows > (m_mf.size() - pos) / (sizeof(pos_t) + sizeof(column_t)))
+            throw_broken();
+
+        m_row_offsets = reinterpret_cast<const pos_t*>(m_mf.data() + pos);
+        pos += sizeof(pos_t) * m_num_rows;
+        m_row_lengths = reinterpret_cast<const column_t*>(m_mf.data() + pos);
+
+        // ROWS MUST BE BETWEEN THE HEADER AND THE INDEX.
+        // A COMPACT ROW HAS ONE BYTE OF COLUMN-ID PER ENTRY AT LEAST.
+        const size_t entry_bytes = distance_bytes() +
+            ((m_format == RM_FORMAT_PLAIN) ? sizeof(column_t) : 1);
+        for (size_t i = 0; i < m_num_rows; ++i)
+        {
+            pos_t offset = m_row_offsets[i];
+            if (m_row_lengths[i] == 0) continue;
+            if (offset < sizeof(pos_t) or offset > index_pos or
+                (index_pos - offset) / entry_bytes < m_row_lengths[i])
+                throw_broken();
         }
+
+        // THE HEADER OF THE INDEX FOLLOWS THE ROWS, SO THAT A VARINT STARTING
+        // BEFORE m_rows_end DOES NOT RUN OUT OF THE FILE.
+        m_rows_end = m_mf.data() + index_pos;
     }
 }
 
@@ -1897,15 +2837,34 @@ void knowledge_base_t::reachable_matrix_t::finalize()
     if (m_fout != NULL)
     {
         std::lock_guard<std::mutex> lock(ms_mutex);
+        size_t num(0), format(m_format);
+
+        for (auto it = m_rows_written.begin(); it != m_rows_written.end(); ++it)
+            num = std::max(num, it->first + 1);
+
+        // ALIGNS THE INDEX TO 8 BYTES SO THAT IT CAN BE READ IN PLACE.
         pos_t pos = m_fout->tellp();
-        size_t num = m_map_idx_to_pos.size();
+        while (pos % sizeof(pos_t) != 0)
+        {
+            m_fout->put('\0');
+            ++pos;
+        }
 
-        m_fout->write((const char*)&num, sizeof(size_t));
+        std::vector<pos_t> offsets(num, 0);
+        std::vector<column_t> lengths(num, 0);
+        for (auto it = m_rows_written.begin(); it != m_rows_written.end(); ++it)
+        {
+            offsets[it->first] = it->second.first;
+            lengths[it->first] = it->second.second;
+        }
 
-        for (auto it = m_map_idx_to_pos.begin(); it != m_map_idx_to_pos.end(); ++it)
+        m_fout->write((const char*)&num, sizeof(size_t));
+        m_fout->write((const char*)&format, sizeof(size_t));
+        m_fout->write((const char*)&m_scale, sizeof(double));
+        if (num > 0)
         {
-            m_fout->write((const char*)&it->first, sizeof(size_t));
-            m_fout->write((const char*)&it->second, sizeof(pos_t));
+            m_fout->write((const char*)&offsets[0], sizeof(pos_t) * num);
+            m_fout->write((const char*)&lengths[0], sizeof(column_t) * num);
         }
 
         m_fout->seekp(0, std::ios::beg);
@@ -1915,94 +2874,208 @@ void knowledge_base_t::reachable_matrix_t::finalize()
         m_fout = NULL;
     }
 
-    if (m_fin != NULL)
-    {
-        delete m_fin;
-        m_fin = NULL;
-    }
-
-    m_map_idx_to_pos.clear();
+    m_mf.close();
+    m_rows_written.clear();
+    m_num_rows = 0;
+    m_row_offsets = NULL;
+    m_row_lengths = NULL;
+    m_rows_end = NULL;
 }
 
 
 void knowledge_base_t::reachable_matrix_t::
 put(size_t idx1, const hash_map<size_t, float> &dist)
 {
-    std::lock_guard<std::mutex> lock(ms_mutex);
-    size_t num(0);
-    m_map_idx_to_pos[idx1] = m_fout->tellp();
+    row_buffer_t buf;
+    put(idx1, dist, &buf);
+    flush(&buf);
+}
 
-    for (auto it = dist.begin(); it != dist.end(); ++it)
-        if (idx1 <= it->first)
-            ++num;
 
-    m_fout->write((const char*)&num, sizeof(size_t));
+void knowledge_base_t::reachable_matrix_t::
+put(size_t idx1, const hash_map<size_t, float> &dist, row_buffer_t *buf)
+{
+    const size_t FLUSH_SIZE(4 * 1024 * 1024);
+    std::vector<std::pair<column_t, float> > row;
+
     for (auto it = dist.begin(); it != dist.end(); ++it)
     {
         if (idx1 <= it->first)
         {
-            m_fout->write((const char*)&it->first, sizeof(size_t));
-            m_fout->write((const char*)&it->second, sizeof(float));
+            if (it->first > std::numeric_limits<column_t>::max())
+                throw phillip_exception_t(
+                "Too many arities to write the reachable-matrix.");
+            row.push_back(std::make_pair(
+                static_cast<column_t>(it->first), it->second));
         }
     }
+
+    std::sort(row.begin(), row.end());
+
+    /* ENCODES THE ROW: DISTANCES FIRST, THEN COLUMN-IDS. */
+    const size_t n = row.size();
+    std::vector<char> &bin = buf->bin;
+    const size_t head = bin.size();
+
+    if (m_format == RM_FORMAT_PLAIN)
+    {
+        bin.resize(head + n * (sizeof(float) + sizeof(column_t)));
+        char *p = bin.data() + head;
+        for (size_t i = 0; i < n; ++i)
+            p += util::to_binary<column_t>(row[i].first, p);
+        for (size_t i = 0; i < n; ++i)
+            p += util::to_binary<float>(row[i].second, p);
+    }
+    else
+    {
+        const double max_code =
+            (m_format == RM_FORMAT_COMPACT8) ? 255.0 : 65535.0;
+        bin.resize(head + n * (distance_bytes() + 5));
+        char *p = bin.data() + head;
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            double q = std::floor(row[i].second * m_scale);
+            if (q > max_code) q = max_code;
+            if (q < 0.0) q = 0.0;
+
+            if (m_format == RM_FORMAT_COMPACT8)
+                p += util::to_binary<uint8_t>(static_cast<uint8_t>(q), p);
+            else
+                p += util::to_binary<uint16_t>(static_cast<uint16_t>(q), p);
+        }
+
+        size_t prev(idx1);
+        for (size_t i = 0; i < n; ++i)
+        {
+            p += util::varint_to_binary(row[i].first - prev, p);
+            prev = row[i].first;
+        }
+
+        bin.resize(p - bin.data());
+    }
+
+    buf->rows.push_back(std::make_pair(
+        idx1, std::make_pair(
+        static_cast<pos_t>(head), static_cast<column_t>(n))));
+
+    if (bin.size() >= FLUSH_SIZE)
+        flush(buf);
 }
 
 
-float knowledge_base_t::reachable_matrix_t::get(size_t idx1, size_t idx2) const
+void knowledge_base_t::reachable_matrix_t::flush(row_buffer_t *buf)
 {
-    if (idx1 > idx2) std::swap(idx1, idx2);
+    if (buf->empty()) return;
 
     std::lock_guard<std::mutex> lock(ms_mutex);
-    size_t num, idx;
-    float dist;
-    auto find = m_map_idx_to_pos.find(idx1);
+    pos_t base = m_fout->tellp();
 
-    if (find == m_map_idx_to_pos.end()) return -1.0f;
+    for (auto it = buf->rows.begin(); it != buf->rows.end(); ++it)
+        m_rows_written[it->first] =
+        std::make_pair(base + it->second.first, it->second.second);
 
-    m_fin->seekg(find->second, std::ios::beg);
-    m_fin->read((char*)&num, sizeof(size_t));
+    if (not buf->bin.empty())
+        m_fout->write(buf->bin.data(), buf->bin.size());
 
-    for (size_t i = 0; i < num; ++i)
+    buf->bin.clear();
+    buf->rows.clear();
+}
+
+
+float knowledge_base_t::reachable_matrix_t::get(size_t idx1, size_t idx2) const
+{
+    if (idx1 > idx2) std::swap(idx1, idx2);
+    if (idx1 >= m_num_rows) return -1.0f;
+
+    size_t num = m_row_lengths[idx1];
+    const char *row = m_mf.data() + m_row_offsets[idx1];
+
+    if (m_format == RM_FORMAT_PLAIN)
     {
-        m_fin->read((char*)&idx, sizeof(size_t));
-        m_fin->read((char*)&dist, sizeof(float));
-        if (idx == idx2) return dist;
+        const column_t *cols = reinterpret_cast<const column_t*>(row);
+        const column_t *found =
+            std::lower_bound(cols, cols + num, static_cast<column_t>(idx2));
+
+        if (found == cols + num or *found != idx2) return -1.0f;
+
+        return decode_distance(
+            reinterpret_cast<const char*>(cols + num), found - cols);
     }
+    else
+    {
+        const char *p = row + num * distance_bytes();
+        unsigned long long col(idx1), delta;
 
-    return -1.0f;
+        for (size_t i = 0; i < num and p < m_rows_end; ++i)
+        {
+            p += util::binary_to_varint(p, &delta);
+            col += delta;
+
+            if (col == idx2) return decode_distance(row, i);
+            if (col > idx2) break;
+        }
+
+        return -1.0f;
+    }
 }
 
 
 hash_set<float> knowledge_base_t::reachable_matrix_t::get(size_t idx) const
 {
-    std::lock_guard<std::mutex> lock(ms_mutex);
-    size_t num;
-    float dist;
     hash_set<float> out;
-    auto find = m_map_idx_to_pos.find(idx);
+    if (idx >= m_num_rows) return out;
 
-    if (find == m_map_idx_to_pos.end()) return out;
+    size_t num = m_row_lengths[idx];
+    const char *dists = m_mf.data() + m_row_offsets[idx];
 
-    m_fin->seekg(find->second, std::ios::beg);
-    m_fin->read((char*)&num, sizeof(size_t));
+    if (m_format == RM_FORMAT_PLAIN)
+        dists += sizeof(column_t) * num;
 
     for (size_t i = 0; i < num; ++i)
+        out.insert(decode_distance(dists, i));
+
+    return out;
+}
+
+
+void knowledge_base_t::reachable_matrix_t::
+get_row(size_t idx, hash_map<size_t, float> *out) const
+{
+    if (idx >= m_num_rows) return;
+
+    size_t num = m_row_lengths[idx];
+    const char *row = m_mf.data() + m_row_offsets[idx];
+
+    if (m_format == RM_FORMAT_PLAIN)
     {
-        m_fin->read((char*)&idx, sizeof(size_t));
-        m_fin->read((char*)&dist, sizeof(float));
-        out.insert(dist);
+        const column_t *cols = reinterpret_cast<const column_t*>(row);
+        const char *dists = reinterpret_cast<const char*>(cols + num);
+
+        for (size_t i = 0; i < num; ++i)
+            (*out)[cols[i]] = decode_distance(dists, i);
     }
+    else
+    {
+        const char *p = row + num * distance_bytes();
+        unsigned long long col(idx), delta;
 
-    return out;
+        for (size_t i = 0; i < num and p < m_rows_end; ++i)
+        {
+            p += util::binary_to_varint(p, &delta);
+            col += delta;
+            (*out)[col] = decode_distance(row, i);
+        }
+    }
 }
 
 
 namespace dist
 {
 
-float basic_distance_provider_t::operator()(const lf::axiom_t &ax) const
+float basic_distance_provider_t::operator()(const lf::axiom_view_t &ax) const
 {
-    auto splitted = util::split(ax.func.param(), ":");
+    auto splitted = util::split(ax.param(), ":");
     float dist;
 
     for (auto s : splitted)
@@ -2015,9 +3088,9 @@ float basic_distance_provider_t::operator()(const lf::axiom_t &ax) const
 }
 
 
-float cost_based_distance_provider_t::operator()(const lf::axiom_t &ax) const
+float cost_based_distance_provider_t::operator()(const lf::axiom_view_t &ax) const
 {
-    const std::string &param = ax.func.param();
+    const std::string &param = ax.param();
     float out(-1.0f);
     _sscanf(param.substr(1).c_str(), "%f", &out);
     return out;
@@ -2026,6 +3099,20 @@ float cost_based_distance_provider_t::operator()(const lf::axiom_t &ax) const
 }
 
 
+void category_table_t::get_neighbors(
+    arity_id_t a1, float threshold, std::vector<arity_id_t> *out) const
+{
+    hash_map<arity_id_t, float> dists;
+    gets(a1, &dists);
+
+    for (auto p : dists)
+    if (p.first != a1 and p.second >= 0.0f and p.second < threshold)
+        out->push_back(p.first);
+
+    std::sort(out->begin(), out->end());
+}
+
+
 namespace ct
 {
 
@@ -2085,6 +3172,15 @@ void basic_category_table_t::prepare_compile(const knowledge_base_t *base)
 }
 
 
+void basic_category_table_t::prepare_append(const knowledge_base_t *base)
+{
+    prepare_compile(base);
+
+    // ENTRIES IN THE TABLE ARE COMBINATED AGAIN WITH NEW ONES ON FINALIZE.
+    read(filename());
+}
+
+
 bool basic_category_table_t::insert(const lf::logical_function_t &ax)
 {
     assert(m_state == STATE_COMPILE);
@@ -2341,75 +3437,6 @@ void basic_category_table_t::read(const std::string &filename)
 }
 
 
-void query_to_binary(const arity_pattern_t &q, std::vector<char> *bin)
-{
-    size_t size_expected =
-        sizeof(unsigned char) * 3 +
-        sizeof(arity_id_t) * std::get<0>(q).size() +
-        (sizeof(arity_id_t) + sizeof(char)) * 2 * std::get<1>(q).size() +
-        sizeof(char) * std::get<2>(q).size();
-    size_t size = 0;
-    bin->assign(size_expected, '\0');
-
-    size += util::num_to_binary(std::get<0>(q).size(), &(*bin)[0]);
-    for (auto id : std::get<0>(q))
-        size += util::to_binary<arity_id_t>(id, &(*bin)[0] + size);
-
-    size += util::num_to_binary(std::get<1>(q).size(), &(*bin)[0] + size);
-    for (auto ht : std::get<1>(q))
-    {
-        size += util::to_binary<arity_id_t>(ht.first.first, &(*bin)[0] + size);
-        size += util::to_binary<char>(ht.first.second, &(*bin)[0] + size);
-        size += util::to_binary<arity_id_t>(ht.second.first, &(*bin)[0] + size);
-        size += util::to_binary<char>(ht.second.second, &(*bin)[0] + size);
-    }
-
-    size += util::num_to_binary(std::get<2>(q).size(), &(*bin)[0] + size);
-    for (auto i : std::get<2>(q))
-        (*bin)[size++] = i;
-
-    assert(size == size_expected);
-};
-
-
-size_t binary_to_query(const char *bin, arity_pattern_t *out)
-{
-    size_t size(0);
-    int num_arity, num_hardterm, num_option;
-
-    std::get<0>(*out).clear();
-    std::get<1>(*out).clear();
-    std::get<2>(*out).clear();
-
-    size += util::binary_to_num(bin + size, &num_arity);
-    for (int i = 0; i < num_arity; ++i)
-    {
-        arity_id_t id;
-        size += util::binary_to<arity_id_t>(bin + size, &id);
-        std::get<0>(*out).push_back(id);
-    }
-
-    size += util::binary_to_num(bin + size, &num_hardterm);
-    for (int i = 0; i < num_hardterm; ++i)
-    {
-        arity_id_t id1, id2;
-        char idx1, idx2;
-        size += util::binary_to<arity_id_t>(bin + size, &id1);
-        size += util::binary_to<char>(bin + size, &idx1);
-        size += util::binary_to<arity_id_t>(bin + size, &id2);
-        size += util::binary_to<char>(bin + size, &idx2);
-        std::get<1>(*out).push_back(std::make_pair(
-            std::make_pair(id1, idx1), std::make_pair(id2, idx2)));
-    }
-
-    size += util::binary_to_num(bin + size, &num_option);
-    for (int i = 0; i < num_option; ++i)
-        std::get<2>(*out).push_back(bin[size++]);
-
-    return size;
-}
-
-
 } // end kb
 
 } // end phil
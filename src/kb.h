@@ -8,7 +8,10 @@
 #include <string>
 #include <memory>
 #include <mutex>
+#include <atomic>
 #include <ctime>
+#include <cstdint>
+#include <cstring>
 
 #include "./define.h"
 #include "./logical_function.h"
@@ -41,18 +44,27 @@ enum version_e
 {
     KB_VERSION_UNDERSPECIFIED,
     KB_VERSION_1, KB_VERSION_2, KB_VERSION_3, KB_VERSION_4, KB_VERSION_5,
-    KB_VERSION_6, KB_VERSION_7, KB_VERSION_8,
+    KB_VERSION_6, KB_VERSION_7, KB_VERSION_8, KB_VERSION_9, KB_VERSION_10,
     NUM_OF_KB_VERSION_TYPES
 };
 
 
+/** Formats of reachable-matrix on the disk. */
+enum reachable_matrix_format_e
+{
+    RM_FORMAT_PLAIN,     /// Sorted 32-bit column-ids and raw distances.
+    RM_FORMAT_COMPACT8,  /// Varint-delta column-ids and 8-bit distances.
+    RM_FORMAT_COMPACT16, /// Varint-delta column-ids and 16-bit distances.
+};
+
+
 /** A virtual class to define distance between predicates
  *  on creation of reachable-matrix. */
 class distance_provider_t
 {
 public:
     virtual ~distance_provider_t() {}
-    virtual float operator() (const lf::axiom_t &ax) const = 0;
+    virtual float operator() (const lf::axiom_view_t &ax) const = 0;
 
     virtual std::string repr() const = 0;
 };
@@ -70,6 +82,10 @@ public:
     virtual void prepare_compile(const knowledge_base_t *base) = 0;
     virtual void prepare_query(const knowledge_base_t *base) = 0;
 
+    /** Prepares for inserting more elements to the compiled table.
+     *  By default, the table is compiled from scratch. */
+    virtual void prepare_append(const knowledge_base_t *base) { prepare_compile(base); }
+
     /** Updates the elements corresponding to given axiom in the table.
      *  Returns whether the axiom had been inserted to this.
      *  This method is called in knowledge_base_t::insert_implication. */
@@ -84,6 +100,11 @@ public:
      *  This method is used on reachable-matrix construction. */
     virtual void gets(const arity_id_t &a1, hash_map<arity_id_t, float> *out) const = 0;
 
+    /** Gets arities whose semantic gap from a1 is less than threshold,
+     *  except a1 itself. This is used on soft-unification. */
+    virtual void get_neighbors(
+        arity_id_t a1, float threshold, std::vector<arity_id_t> *out) const;
+
     virtual bool do_target(const arity_t &a) const = 0;
 
     virtual void finalize() = 0;
@@ -116,6 +137,100 @@ private:
 };
 
 
+/** A bounded cache of views of decoded axioms, which is shared among threads.
+ *  Entries are distributed to shards with their own locks,
+ *  and each shard discards its least-recently-used entry when it is full. */
+class axiom_cache_t
+{
+public:
+    typedef std::shared_ptr<const lf::axiom_view_t> axiom_ptr_t;
+
+    axiom_cache_t(size_t capacity = 0);
+
+    /** Returns the cached axiom, or NULL if it is not cached. */
+    axiom_ptr_t find(axiom_id_t id) const;
+    void insert(axiom_id_t id, const axiom_ptr_t &ptr);
+    void clear();
+
+    void set_capacity(size_t capacity);
+    inline size_t capacity() const { return m_capacity; }
+    inline unsigned long long num_hits() const { return m_num_hits; }
+    inline unsigned long long num_misses() const { return m_num_misses; }
+
+private:
+    static const size_t NUM_SHARDS = 16;
+
+    struct shard_t
+    {
+        std::mutex mutex;
+        std::list<axiom_id_t> order; /// Ids sorted from the most recent.
+        hash_map<axiom_id_t,
+            std::pair<axiom_ptr_t, std::list<axiom_id_t>::iterator> > entries;
+    };
+
+    inline shard_t& shard(axiom_id_t id) const
+    { return m_shards[static_cast<size_t>(id) % NUM_SHARDS]; }
+
+    mutable shard_t m_shards[NUM_SHARDS];
+    size_t m_capacity, m_capacity_per_shard;
+    mutable std::atomic<unsigned long long> m_num_hits, m_num_misses;
+};
+
+
+/** A bounded cache of distances between arities, which is shared among threads.
+ *  A pair of arity-ids is packed into a 64-bit key and entries are
+ *  distributed to shards with their own locks.
+ *  Each shard keeps two generations of entries and discards the older one
+ *  when the newer one gets full, so that entries used recently survive. */
+class distance_cache_t
+{
+public:
+    distance_cache_t(size_t max_bytes = 0);
+
+    /** Returns whether the distance is cached and if so, sets it to out. */
+    bool find(arity_id_t a1, arity_id_t a2, float *out) const;
+    void insert(arity_id_t a1, arity_id_t a2, float dist) const;
+    void clear();
+
+    void set_max_bytes(size_t max_bytes);
+    inline size_t max_bytes() const { return m_max_bytes; }
+    size_t size() const;
+    inline unsigned long long num_hits() const { return m_num_hits; }
+    inline unsigned long long num_misses() const { return m_num_misses; }
+
+private:
+    typedef unsigned long long key_t;
+    static const size_t NUM_SHARDS = 64;
+
+    /** Estimated bytes of an entry in hash_map, including the bucket. */
+    static const size_t ENTRY_BYTES =
+        sizeof(std::pair<const key_t, float>) + 3 * sizeof(void*);
+
+    struct shard_t
+    {
+        std::mutex mutex;
+        hash_map<key_t, float> recent, old;
+    };
+
+    /** Packs a pair of arity-ids, which is regarded as unordered. */
+    static inline key_t pack(arity_id_t a1, arity_id_t a2)
+    {
+        if (a1 > a2) std::swap(a1, a2);
+        return (static_cast<key_t>(a1) << 32) | static_cast<key_t>(a2 & 0xffffffff);
+    }
+
+    inline shard_t& shard(key_t key) const
+    { return m_shards[(key * 0x9e3779b97f4a7c15ULL) >> 58]; }
+
+    /** Inserts an entry to the newer generation. The lock must be held. */
+    void put(shard_t *sh, key_t key, float dist) const;
+
+    mutable shard_t m_shards[NUM_SHARDS];
+    size_t m_max_bytes, m_capacity_per_generation;
+    mutable std::atomic<unsigned long long> m_num_hits, m_num_misses;
+};
+
+
 /** A class of knowledge-base. */
 class knowledge_base_t
 {
@@ -123,7 +238,9 @@ public:
     static knowledge_base_t* instance();
     static void setup(
         std::string filename, float max_distance,
-        int thread_num_for_rm, bool do_disable_stop_word);
+        int thread_num_for_rm, bool do_disable_stop_word,
+        reachable_matrix_format_e rm_format = RM_FORMAT_PLAIN,
+        size_t axiom_cache_size = 0, size_t distance_cache_bytes = 0);
     static inline float get_max_distance();
 
     ~knowledge_base_t();
@@ -132,33 +249,65 @@ public:
      *  prepares for compiling knowledge base. */
     void prepare_compile();
 
+    /** Prepares for appending axioms to the compiled knowledge base.
+     *  Axioms inserted after this are written to the delta segment,
+     *  and only the rows of reachable-matrix which may be changed
+     *  by them are recomputed on finalize(). */
+    void prepare_append();
+
     /** Prepares for reading knowledge base. */
     void prepare_query();
 
     /** Call this method on end of compiling or reading knowledge base. */
     void finalize();
 
+    /** Inserts an implication or a paraphrase.
+     *  @param bin The binary of f encoded beforehand, if any. */
     axiom_id_t insert_implication(
-        const lf::logical_function_t &f, const std::string &name);
+        const lf::logical_function_t &f, const std::string &name,
+        const std::vector<char> *bin = NULL);
     void insert_inconsistency(const lf::logical_function_t &f);
     void insert_unification_postponement(const lf::logical_function_t &f);
     void insert_argument_set(const lf::logical_function_t &f);
     void assert_stop_word(const arity_t &arity);
 
     inline lf::axiom_t get_axiom(axiom_id_t id) const;
+
+    /** Returns the flat view of the axiom,
+     *  which is decoded without building the tree of logical-function. */
+    inline lf::axiom_view_t get_axiom_view(axiom_id_t id) const;
+
+    /** Returns the view of the axiom decoded once and shared through the axiom cache.
+     *  Use this instead of get_axiom() on inference,
+     *  where the same axioms are looked up repeatedly. */
+    axiom_cache_t::axiom_ptr_t get_cached_axiom(axiom_id_t id) const;
+    inline const axiom_cache_t& axiom_cache() const { return m_axiom_cache; }
+
     inline std::list<axiom_id_t> search_axioms_with_rhs(const std::string &arity) const;
     inline std::list<axiom_id_t> search_axioms_with_lhs(const std::string &arity) const;
     inline const std::list<std::pair<term_idx_t, term_idx_t> >*
         search_inconsistent_terms(arity_id_t a1, arity_id_t a2) const;
     inline arity_id_t search_arity_id(const arity_t &arity) const;
+
+    /** Returns the id of the arity of lit without formatting its arity. */
+    inline arity_id_t search_arity_id(const literal_t &lit) const;
     inline const arity_t& search_arity(arity_id_t id) const;
+    inline size_t num_arities() const { return m_arity_db.arities().size(); }
     hash_set<axiom_id_t> search_axiom_group(axiom_id_t id) const;
     inline const unification_postponement_t* find_unification_postponement(arity_id_t arity) const;
     inline const unification_postponement_t* find_unification_postponement(const arity_t &arity) const;
     argument_set_id_t search_argument_set_id(const std::string &arity, int term_idx) const;
-    void search_arity_patterns(arity_id_t arity, std::list<arity_pattern_t> *out) const;
+
+    /** Appends ids of arity-patterns which include given arity to out. */
+    void search_arity_patterns(arity_id_t arity, std::vector<arity_pattern_id_t> *out) const;
+    inline arity_pattern_view_t get_arity_pattern(arity_pattern_id_t id) const;
+
+    /** Returns whether the pattern of id a precedes that of id b
+     *  in the order of their contents. */
+    inline bool arity_pattern_precedes(arity_pattern_id_t a, arity_pattern_id_t b) const;
+
     void search_axioms_with_arity_pattern(
-        const arity_pattern_t &query,
+        arity_pattern_id_t id,
         std::list<std::pair<axiom_id_t, bool> > *out) const;
 
     void set_distance_provider(const std::string &key, phillip_main_t *ph = NULL);
@@ -169,9 +318,10 @@ public:
      *  If these arities are not reachable, then return -1. */
     float get_distance(
         const std::string &arity1, const std::string &arity2) const;
+    float get_distance(arity_id_t arity1, arity_id_t arity2) const;
 
     /** Returns distance between arity1 and arity2 with distance-provider. */
-    inline float get_distance(const lf::axiom_t &axiom) const;
+    inline float get_distance(const lf::axiom_view_t &axiom) const;
     inline float get_distance(axiom_id_t id) const;
 
     const category_table_t* category_table() const { return m_category_table.instance; }
@@ -184,21 +334,28 @@ public:
     inline int num_of_axioms() const;
     inline const hash_set<std::string>& stop_words() const;
 
+    /** Caches the distances from the arities given,
+     *  which are expected to be looked up in the following inferences. */
+    void prewarm_distance_cache(const hash_set<arity_id_t> &arities) const;
     inline void clear_distance_cache();
+    inline const distance_cache_t& distance_cache() const { return m_distance_cache; }
 
 private:
     class axioms_database_t
     {
     public:
-        axioms_database_t(const std::string &filename);
+        axioms_database_t(const std::string &filename, bool is_delta = false);
         ~axioms_database_t();
 
         void prepare_compile();
         void prepare_query();
         void finalize();
 
-        void put(const std::string &name, const lf::logical_function_t &func);
+        void put(
+            const std::string &name, const lf::logical_function_t &func,
+            const std::vector<char> *bin = NULL);
         lf::axiom_t get(axiom_id_t id) const;
+        lf::axiom_view_t get_view(axiom_id_t id) const;
         inline bool is_writable() const;
         inline bool is_readable() const;
         inline int num_axioms() const { return m_num_compiled_axioms; }
@@ -209,10 +366,23 @@ private:
 
         inline std::string get_name_of_unnamed_axiom();
 
+        /** Returns the binary of the axiom in the mapped region,
+         *  or NULL if it is not available. */
+        const char* find_binary(axiom_id_t id) const;
+
         static std::mutex ms_mutex;
         std::string m_filename;
         std::ofstream *m_fo_idx, *m_fo_dat;
-        std::ifstream *m_fi_idx, *m_fi_dat;
+
+        /** Whether this is a delta segment.
+         *  Unnamed axioms in a delta segment are named by their local ids,
+         *  so that their names never conflict with those in the base. */
+        bool m_is_delta;
+
+        /** Memory-mapped index and data files.
+         *  Because these are read-only, get() needs no lock. */
+        util::mapped_file_t m_mf_idx, m_mf_dat;
+
         int m_num_compiled_axioms, m_num_unnamed_axioms;
         axiom_pos_t m_writing_pos;
     };
@@ -232,6 +402,7 @@ private:
 
         inline const std::vector<arity_t>& arities() const;
         inline arity_id_t arity2id(const arity_t&) const;
+        inline arity_id_t arity2id(const string_hash_t&) const;
         inline const arity_t& id2arity(arity_id_t) const;
         inline const unification_postponement_t*
             find_unification_postponement(arity_id_t) const;
@@ -244,35 +415,196 @@ private:
         std::vector<arity_t> m_arities;
         hash_map<arity_t, arity_id_t> m_arity2id;
 
+        /** Ids of arities indexed by the hashes of their interned strings. */
+        std::vector<arity_id_t> m_hash2id;
+
         hash_map<arity_id_t, unification_postponement_t> m_unification_postponements;
         hash_map<arity_id_t, hash_map<arity_id_t,
             std::list<std::pair<term_idx_t, term_idx_t> > > > m_mutual_exclusions;
     };
 
-    /** A class of reachable-matrix for all predicate pairs. */
+    /** A class of reachable-matrix for all predicate pairs.
+     *  Each row holds only the columns not less than its own index.
+     *  On the disk, a row is stored as an array of column-ids sorted
+     *  in ascending order and the array of corresponding distances,
+     *  and the offsets and lengths of rows are stored at the end of file.
+     *  On query, the file is mapped into memory and rows are probed
+     *  without any lock.
+     *  In the compact formats, distances are quantized to multiples of
+     *  a power-of-two fraction with rounding down, so that the stored value
+     *  never exceeds the true distance, and column-ids are encoded
+     *  as varint deltas, which are decoded on demand. */
     class reachable_matrix_t
     {
     public:
+        typedef unsigned long long pos_t;
+        typedef uint32_t column_t;
+
+        /** A buffer of encoded rows owned by one thread.
+         *  Rows are flushed to the file in bulk,
+         *  so that writers rarely contend for the lock. */
+        class row_buffer_t
+        {
+        public:
+            bool empty() const { return rows.empty(); }
+
+            std::vector<char> bin;
+            std::vector<std::pair<size_t, std::pair<pos_t, column_t> > > rows;
+        };
+
         reachable_matrix_t(const std::string &filename);
         ~reachable_matrix_t();
-        void prepare_compile();
+        void prepare_compile(
+            reachable_matrix_format_e format = RM_FORMAT_PLAIN,
+            float max_distance = -1.0f);
         void prepare_query();
         void finalize();
 
         void put(size_t idx1, const hash_map<size_t, float> &dist);
+
+        /** Encodes a row into the buffer without any lock.
+         *  The buffer is flushed when it has grown large. */
+        void put(size_t idx1, const hash_map<size_t, float> &dist, row_buffer_t *buf);
+
+        /** Writes rows in the buffer to the file and clears it. */
+        void flush(row_buffer_t *buf);
+
         float get(size_t idx1, size_t idx2) const;
         hash_set<float> get(size_t idx) const;
 
+        /** Gets all elements in the row of idx. */
+        void get_row(size_t idx, hash_map<size_t, float> *out) const;
+
+        /** Returns whether the row of idx has been written to the file. */
+        inline bool has_row(size_t idx) const;
+
         inline bool is_writable() const;
         inline bool is_readable() const;
+        inline reachable_matrix_format_e format() const { return m_format; }
 
     private:
-        typedef unsigned long long pos_t;
+        inline size_t distance_bytes() const;
+        inline float decode_distance(const char *dists, size_t i) const;
+
         static std::mutex ms_mutex;
         std::string   m_filename;
         std::ofstream *m_fout;
-        std::ifstream *m_fin;
-        hash_map<size_t, pos_t> m_map_idx_to_pos;
+        hash_map<size_t, std::pair<pos_t, column_t> > m_rows_written;
+
+        reachable_matrix_format_e m_format;
+        double m_scale; /// Inverse of the quantization step.
+
+        util::mapped_file_t m_mf;
+        size_t m_num_rows;
+        const pos_t *m_row_offsets;
+        const column_t *m_row_lengths;
+
+        /** The end of rows, where the index begins.
+         *  Column-ids of compact rows are not decoded beyond this. */
+        const char *m_rows_end;
+    };
+
+    /** A flat table of arity-patterns, which is read by memory-mapping.
+     *  The id of a pattern is its position in this table. */
+    class arity_pattern_table_t
+    {
+    public:
+        typedef unsigned long long pos_t;
+
+        arity_pattern_table_t(const std::string &filename);
+
+        /** Writes given patterns to the file in the order. */
+        void write(const std::vector<const arity_pattern_t*> &patterns) const;
+        void prepare_query();
+        void finalize();
+
+        inline size_t size() const { return m_num_patterns; }
+        inline arity_pattern_view_t get(arity_pattern_id_t id) const;
+        inline const std::string& filename() const { return m_filename; }
+
+    private:
+        std::string m_filename;
+        util::mapped_file_t m_mf;
+        size_t m_num_patterns;
+        const pos_t *m_offsets; /// Offsets of patterns in words.
+        const arity_pattern_view_t::word_t *m_words;
+    };
+
+    /** The graph of direct edges between arities in the CSR format,
+     *  which is built from the output of _create_reachable_matrix_direct.
+     *  Edges from arity i are in [offsets[i], offsets[i+1]). */
+    class reachability_graph_t
+    {
+    public:
+        struct edge_t
+        {
+            uint32_t target;
+            bool is_paraphrasal;
+            float dist;
+        };
+
+        reachability_graph_t(
+            size_t num_arities,
+            const hash_map<arity_id_t, hash_map<arity_id_t, float> > &base_lhs,
+            const hash_map<arity_id_t, hash_map<arity_id_t, float> > &base_rhs,
+            const std::set<std::pair<arity_id_t, arity_id_t> > &base_para);
+
+        inline size_t size() const { return m_is_node.size(); }
+        inline bool is_node(arity_id_t i) const { return m_is_node.at(i) != 0; }
+
+        /** Returns the range of forward (LHS -> RHS) edges from i. */
+        inline std::pair<const edge_t*, const edge_t*> lhs_edges(arity_id_t i) const
+        { return std::make_pair(&m_lhs_edges[0] + m_lhs_offsets[i], &m_lhs_edges[0] + m_lhs_offsets[i + 1]); }
+
+        /** Returns the range of backward (RHS -> LHS) edges from i. */
+        inline std::pair<const edge_t*, const edge_t*> rhs_edges(arity_id_t i) const
+        { return std::make_pair(&m_rhs_edges[0] + m_rhs_offsets[i], &m_rhs_edges[0] + m_rhs_offsets[i + 1]); }
+
+    private:
+        static void freeze(
+            size_t num_arities,
+            const hash_map<arity_id_t, hash_map<arity_id_t, float> > &base,
+            const std::set<std::pair<arity_id_t, arity_id_t> > &base_para,
+            std::vector<size_t> *offsets, std::vector<edge_t> *edges);
+
+        std::vector<char> m_is_node;
+        std::vector<size_t> m_lhs_offsets, m_rhs_offsets;
+        std::vector<edge_t> m_lhs_edges, m_rhs_edges;
+    };
+
+    /** Working memory of the search in _create_reachable_matrix_indirect.
+     *  Each thread owns one and reuses it for all rows,
+     *  so that the dense state array is not reallocated per row. */
+    struct reachability_search_buffer_t
+    {
+        /** Distances of states, indexed by arity * 4 + flags. */
+        std::vector<float> dists;
+        std::vector<size_t> touched;
+        util::radix_heap_t<size_t> heap;
+    };
+
+    /** Databases for axioms appended after the last full compilation.
+     *  Ids of axioms in this segment follow those in the base segment,
+     *  and rows of the reachable-matrix in this segment
+     *  override the corresponding rows in the base segment. */
+    struct delta_segment_t
+    {
+        delta_segment_t(const std::string &prefix);
+
+        void prepare_compile();
+        void prepare_query();
+        void finalize();
+
+        /** Removes the files of this segment. */
+        void remove();
+
+        std::string prefix;
+        axioms_database_t axioms;
+        util::cdb_data_t cdb_rhs, cdb_lhs;
+        util::cdb_data_t cdb_axiom_group, cdb_arg_set;
+        util::cdb_data_t cdb_arity_patterns, cdb_pattern_to_ids;
+        arity_pattern_table_t arity_patterns;
+        reachable_matrix_t rm;
     };
 
     enum kb_state_e { STATE_NULL, STATE_COMPILE, STATE_QUERY };
@@ -289,6 +621,15 @@ private:
     void set_stop_words();
     void create_query_map();
     void create_reachable_matrix();
+
+    /** Returns the arities whose rows in reachable-matrix
+     *  may be changed by the axioms inserted on appending. */
+    void _enumerate_arities_to_update(
+        const reachability_graph_t &graph, const hash_set<arity_id_t> &ignored,
+        hash_set<arity_id_t> *out) const;
+
+    /** Returns the distance in the reachable-matrix without the cache. */
+    float _get_distance(arity_id_t a1, arity_id_t a2) const;
     
     void _create_reachable_matrix_direct(
         const hash_set<arity_id_t> &ignored,
@@ -296,10 +637,8 @@ private:
         hash_map<arity_id_t, hash_map<arity_id_t, float> > *out_rhs,
         std::set<std::pair<arity_id_t, arity_id_t> > *out_para);
     void _create_reachable_matrix_indirect(
-        arity_id_t target,
-        const hash_map<arity_id_t, hash_map<arity_id_t, float> > &base_lhs,
-        const hash_map<arity_id_t, hash_map<arity_id_t, float> > &base_rhs,
-        const std::set<std::pair<arity_id_t, arity_id_t> > &base_para,
+        arity_id_t target, const reachability_graph_t &graph,
+        reachability_search_buffer_t *buf,
         hash_map<arity_id_t, float> *out) const;
 
     void extend_inconsistency();
@@ -319,20 +658,37 @@ private:
     static float ms_max_distance;
     static int ms_thread_num_for_rm;
     static bool ms_do_disable_stop_word;
-    static std::mutex ms_mutex_for_cache;
+    static reachable_matrix_format_e ms_rm_format;
+    static size_t ms_axiom_cache_size;
+    static size_t ms_distance_cache_bytes;
     static std::mutex ms_mutex_for_rm;
 
     kb_state_e m_state;
     std::string m_filename;
     version_e m_version;
 
+    /** Whether the delta segment is written or read. */
+    bool m_is_appending, m_has_delta;
+
     util::cdb_data_t m_cdb_rhs, m_cdb_lhs;
     util::cdb_data_t m_cdb_axiom_group, m_cdb_arg_set;
     util::cdb_data_t m_cdb_arity_patterns, m_cdb_pattern_to_ids;
+    arity_pattern_table_t m_arity_patterns;
     axioms_database_t m_axioms;
     arity_database_t m_arity_db;
     reachable_matrix_t m_rm;
 
+    /** Decoded axioms which are kept across observations. */
+    mutable axiom_cache_t m_axiom_cache;
+    delta_segment_t m_delta;
+
+    /** Arities which appear in the axioms inserted on appending. */
+    hash_set<arity_id_t> m_appended_arities;
+    size_t m_num_base_arities;
+
+    /** Rows of reachable-matrix in the previous delta segment. */
+    hash_map<size_t, hash_map<size_t, float> > m_previous_delta_rows;
+
     hash_map<size_t, hash_map<size_t, float> > m_partial_reachable_matrix;
 
     /** A set of arities of stop-words.
@@ -361,7 +717,8 @@ private:
         std::string key;
     } m_category_table;
 
-    mutable hash_map<size_t, hash_map<size_t, float> > m_cache_distance;
+    /** Distances between arities which are kept across observations. */
+    distance_cache_t m_distance_cache;
 };
 
 
@@ -378,7 +735,7 @@ public:
             { return new basic_distance_provider_t(); }
     };
     
-    virtual float operator() (const lf::axiom_t&) const;
+    virtual float operator() (const lf::axiom_view_t&) const;
     virtual std::string repr() const { return "Basic"; };
 };
 
@@ -392,7 +749,7 @@ public:
             { return new cost_based_distance_provider_t(); }
     };
     
-    virtual float operator()(const lf::axiom_t&) const;
+    virtual float operator()(const lf::axiom_view_t&) const;
     virtual std::string repr() const { return "CostBased"; }
 };
 
@@ -441,6 +798,7 @@ public:
     basic_category_table_t(int max_depth, float dist_scale);
     
     virtual void prepare_compile(const knowledge_base_t*) override;
+    virtual void prepare_append(const knowledge_base_t*) override;
     virtual bool insert(const lf::logical_function_t &ax) override;
 
     virtual void prepare_query(const knowledge_base_t*) override;
@@ -471,9 +829,6 @@ protected:
 }
 
 
-void query_to_binary(const arity_pattern_t &q, std::vector<char> *bin);
-size_t binary_to_query(const char *bin, arity_pattern_t *out);
-
 inline knowledge_base_t* kb() { return knowledge_base_t::instance(); }
 
 }
@@ -19,16 +19,62 @@ inline lf::axiom_t knowledge_base_t::get_axiom(axiom_id_t id) const
 {
     if (id >= 0 and id < m_axioms.num_axioms())
         return m_axioms.get(id);
+    else if (id >= 0 and id < num_of_axioms())
+    {
+        lf::axiom_t out = m_delta.axioms.get(id - m_axioms.num_axioms());
+        out.id = id;
+        return out;
+    }
     else
         return lf::axiom_t();
 }
 
 
+inline lf::axiom_view_t knowledge_base_t::get_axiom_view(axiom_id_t id) const
+{
+    if (id >= 0 and id < m_axioms.num_axioms())
+        return m_axioms.get_view(id);
+    else if (id >= 0 and id < num_of_axioms())
+    {
+        lf::axiom_view_t out = m_delta.axioms.get_view(id - m_axioms.num_axioms());
+        out.id = id;
+        return out;
+    }
+    else
+        return lf::axiom_view_t();
+}
+
+
+inline arity_pattern_view_t knowledge_base_t::
+get_arity_pattern(arity_pattern_id_t id) const
+{
+    return (id < m_arity_patterns.size()) ?
+        m_arity_patterns.get(id) :
+        m_delta.arity_patterns.get(id - m_arity_patterns.size());
+}
+
+
+inline bool knowledge_base_t::
+arity_pattern_precedes(arity_pattern_id_t a, arity_pattern_id_t b) const
+{
+    // IDS IN EACH SEGMENT ARE ASSIGNED IN THE ORDER OF PATTERNS.
+    size_t n = m_arity_patterns.size();
+    if ((a < n) == (b < n)) return a < b;
+
+    return get_arity_pattern(a) < get_arity_pattern(b);
+}
+
+
 inline std::list<axiom_id_t> knowledge_base_t::
 search_axioms_with_rhs(const std::string &rhs) const
 {
     arity_id_t id = m_arity_db.arity2id(rhs);
-    return search_id_list(id, &m_cdb_rhs);
+    std::list<axiom_id_t> out = search_id_list(id, &m_cdb_rhs);
+
+    if (m_has_delta)
+        out.splice(out.end(), search_id_list(id, &m_delta.cdb_rhs));
+
+    return out;
 }
 
 
@@ -36,7 +82,12 @@ inline std::list<axiom_id_t> knowledge_base_t::
 search_axioms_with_lhs(const std::string &lhs) const
 {
     arity_id_t id = m_arity_db.arity2id(lhs);
-    return search_id_list(lhs, &m_cdb_lhs);
+    std::list<axiom_id_t> out = search_id_list(lhs, &m_cdb_lhs);
+
+    if (m_has_delta)
+        out.splice(out.end(), search_id_list(lhs, &m_delta.cdb_lhs));
+
+    return out;
 }
 
 
@@ -47,7 +98,7 @@ search_inconsistent_terms(arity_id_t a1, arity_id_t a2) const
 }
 
 
-inline float knowledge_base_t::get_distance(const lf::axiom_t &axiom) const
+inline float knowledge_base_t::get_distance(const lf::axiom_view_t &axiom) const
 {
     return (*m_distance_provider.instance)(axiom);
 }
@@ -55,7 +106,7 @@ inline float knowledge_base_t::get_distance(const lf::axiom_t &axiom) const
 
 inline float knowledge_base_t::get_distance(axiom_id_t id) const
 {
-    return get_distance(get_axiom(id));
+    return get_distance(*get_cached_axiom(id));
 }
 
 
@@ -67,7 +118,7 @@ inline version_e knowledge_base_t::version() const
 
 inline bool knowledge_base_t::is_valid_version() const
 {
-    return m_version == KB_VERSION_8;
+    return m_version == KB_VERSION_10;
 }
 
 
@@ -85,7 +136,8 @@ inline bool knowledge_base_t::is_readable() const
 
 inline int knowledge_base_t::num_of_axioms() const
 {
-    return m_axioms.num_axioms();
+    return m_axioms.num_axioms() +
+        ((m_is_appending or m_has_delta) ? m_delta.axioms.num_axioms() : 0);
 }
 
 
@@ -103,8 +155,7 @@ inline const std::string& knowledge_base_t::filename() const
 
 inline void knowledge_base_t::clear_distance_cache()
 {
-    std::lock_guard<std::mutex> lock(ms_mutex_for_cache);
-    m_cache_distance.clear();
+    m_distance_cache.clear();
 }
 
 
@@ -114,6 +165,12 @@ inline arity_id_t knowledge_base_t::search_arity_id(const arity_t &arity) const
 }
 
 
+inline arity_id_t knowledge_base_t::search_arity_id(const literal_t &lit) const
+{
+    return m_arity_db.arity2id(lit.get_arity_hash());
+}
+
+
 inline const arity_t& knowledge_base_t::search_arity(arity_id_t id) const
 {
     return m_arity_db.id2arity(id);
@@ -142,14 +199,17 @@ inline bool knowledge_base_t::axioms_database_t::is_writable() const
 
 inline bool knowledge_base_t::axioms_database_t::is_readable() const
 {
-    return (m_fi_idx != NULL) and (m_fi_dat != NULL);
+    return m_mf_idx.is_open() and m_mf_dat.is_open();
 }
 
 
 inline std::string knowledge_base_t::axioms_database_t::get_name_of_unnamed_axiom()
 {
     char buf[128];
-    _sprintf(buf, "_%#.8lx", m_num_unnamed_axioms++);
+    if (m_is_delta)
+        _sprintf(buf, "_delta%#.8lx", static_cast<unsigned long>(m_num_compiled_axioms));
+    else
+        _sprintf(buf, "_%#.8lx", m_num_unnamed_axioms++);
     return std::string(buf);
 }
 
@@ -165,6 +225,12 @@ arity_id_t knowledge_base_t::arity_database_t::add(const arity_t &arity)
         arity_id_t id = m_arities.size();
         m_arity2id[arity] = id;
         m_arities.push_back(arity);
+
+        unsigned hash = string_hash_t(arity).get_hash();
+        if (hash >= m_hash2id.size())
+            m_hash2id.resize(hash + 1, INVALID_ARITY_ID);
+        m_hash2id[hash] = id;
+
         return id;
     }
 }
@@ -191,6 +257,13 @@ inline arity_id_t knowledge_base_t::arity_database_t::arity2id(const arity_t &ar
 }
 
 
+inline arity_id_t knowledge_base_t::arity_database_t::arity2id(const string_hash_t &arity) const
+{
+    return (arity.get_hash() < m_hash2id.size()) ?
+        m_hash2id[arity.get_hash()] : INVALID_ARITY_ID;
+}
+
+
 inline const arity_t& knowledge_base_t::arity_database_t::id2arity(arity_id_t id) const
 {
     return (id < m_arities.size()) ? m_arities.at(id) : m_arities.front();    
@@ -229,7 +302,59 @@ inline bool knowledge_base_t::reachable_matrix_t::is_writable() const
 
 inline bool knowledge_base_t::reachable_matrix_t::is_readable() const
 {
-    return (m_fin != NULL);
+    return m_mf.is_open();
+}
+
+
+inline bool knowledge_base_t::reachable_matrix_t::has_row(size_t idx) const
+{
+    // THE OFFSET OF A ROW IS ZERO ONLY IF IT HAS NOT BEEN WRITTEN.
+    return (idx < m_num_rows and m_row_offsets[idx] != 0);
+}
+
+
+inline arity_pattern_view_t
+knowledge_base_t::arity_pattern_table_t::get(arity_pattern_id_t id) const
+{
+    return arity_pattern_view_t(m_words + m_offsets[id]);
+}
+
+
+inline size_t knowledge_base_t::reachable_matrix_t::distance_bytes() const
+{
+    switch (m_format)
+    {
+    case RM_FORMAT_COMPACT8: return sizeof(uint8_t);
+    case RM_FORMAT_COMPACT16: return sizeof(uint16_t);
+    default: return sizeof(float);
+    }
+}
+
+
+inline float knowledge_base_t::reachable_matrix_t::
+decode_distance(const char *dists, size_t i) const
+{
+    switch (m_format)
+    {
+    case RM_FORMAT_COMPACT8:
+    {
+        uint8_t q;
+        std::memcpy(&q, dists + i * sizeof(uint8_t), sizeof(uint8_t));
+        return static_cast<float>(q / m_scale);
+    }
+    case RM_FORMAT_COMPACT16:
+    {
+        uint16_t q;
+        std::memcpy(&q, dists + i * sizeof(uint16_t), sizeof(uint16_t));
+        return static_cast<float>(q / m_scale);
+    }
+    default:
+    {
+        float d;
+        std::memcpy(&d, dists + i * sizeof(float), sizeof(float));
+        return d;
+    }
+    }
 }
 
 
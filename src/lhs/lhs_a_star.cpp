@@ -60,10 +60,10 @@ pg::proof_graph_t* a_star_based_enumerator_t::execute() const
 
         if (considered.count(static_cast<pg::chain_candidate_t>(cand)) == 0)
         {
-            lf::axiom_t axiom = base->get_axiom(cand.axiom_id);
+            auto axiom = base->get_cached_axiom(cand.axiom_id);
             pg::hypernode_idx_t hn_new = cand.is_forward ?
-                graph->forward_chain(cand.nodes, axiom) :
-                graph->backward_chain(cand.nodes, axiom);
+                graph->forward_chain(cand.nodes, *axiom) :
+                graph->backward_chain(cand.nodes, *axiom);
             
             if (hn_new >= 0)
             {
@@ -95,7 +95,7 @@ pg::proof_graph_t* a_star_based_enumerator_t::execute() const
 
                 for (auto p : from2goals)
                 {
-                    float dist = p.second.first + base->get_distance(axiom);
+                    float dist = p.second.first + base->get_distance(*axiom);
 
                     for (auto n : nodes_new)
                     {
@@ -136,8 +136,7 @@ const pg::proof_graph_t *graph, reachability_manager_t *out) const
     for (auto n2 = obs.begin(); n2 != n1; ++n2)
     {
         float dist = kb->get_distance(
-            graph->node(*n1).literal().get_arity(),
-            graph->node(*n2).literal().get_arity());
+            graph->node(*n1).arity_id(), graph->node(*n2).arity_id());
 
         if (check_permissibility_of(dist))
         {
@@ -157,9 +156,10 @@ void a_star_based_enumerator_t::add_reachability(
 
     hash_set<pg::node_idx_t> goals_filtered;
     {
-        arity_t arity_current = graph->node(current).arity();
+        const string_hash_t &arity_current =
+            graph->node(current).literal().get_arity_hash();
         for (auto g : goals)
-        if (graph->node(g).arity() != arity_current)
+        if (graph->node(g).literal().get_arity_hash() != arity_current)
             goals_filtered.insert(g);
     }
     if (goals_filtered.empty()) return;
@@ -169,24 +169,25 @@ void a_star_based_enumerator_t::add_reachability(
     {
         for (auto ax : gen.axioms())
         {
-            lf::axiom_t axiom = kb::kb()->get_axiom(ax.first);
-            float d_from = dist + kb::kb()->get_distance(axiom);
+            auto axiom = kb::kb()->get_cached_axiom(ax.first);
+            float d_from = dist + kb::kb()->get_distance(*axiom);
             
             if (not check_permissibility_of(d_from)) continue;
             
             for (auto g : goals_filtered)
             {
-                std::string arity_goal = graph->node(g).arity();
+                kb::arity_id_t arity_goal = graph->node(g).arity_id();
 
                 for (auto tar : gen.targets())
                 {
                     auto lits = not kb::is_backward(ax) ?
-                        axiom.func.get_rhs() : axiom.func.get_lhs();
+                        axiom->rhs() : axiom->lhs();
                     float d_to(-1.0f);
 
-                    for (auto l : lits)
+                    for (const auto &l : lits)
                     {
-                        float d = kb::kb()->get_distance(l->get_arity(), arity_goal);
+                        float d = kb::kb()->get_distance(
+                            kb::kb()->search_arity_id(l), arity_goal);
                         if ((d_to < 0.0f or d_to > d)
                             and check_permissibility_of(d))
                             d_to = d;
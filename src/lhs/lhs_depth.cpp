@@ -39,7 +39,7 @@ pg::proof_graph_t* depth_based_enumerator_t::execute() const
 
     for (int depth = 0; (m_depth_max < 0 or depth < m_depth_max); ++depth)
     {
-        const hash_set<pg::node_idx_t>
+        const std::vector<pg::node_idx_t>
             *nodes = graph->search_nodes_with_depth(depth);
         if (nodes == NULL) break;
 
@@ -62,13 +62,13 @@ pg::proof_graph_t* depth_based_enumerator_t::execute() const
 
         for (auto p : candidates)
         {
-            const lf::axiom_t &axiom = kb::kb()->get_axiom(p.first);
+            auto axiom = kb::kb()->get_cached_axiom(p.first);
 
             for (auto c : p.second)
             {
                 pg::hypernode_idx_t to = c.is_forward ?
-                    graph->forward_chain(c.nodes, axiom) :
-                    graph->backward_chain(c.nodes, axiom);
+                    graph->forward_chain(c.nodes, *axiom) :
+                    graph->backward_chain(c.nodes, *axiom);
 
                 if (to >= 0) ++chain_num;
             }
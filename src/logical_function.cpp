@@ -105,9 +105,9 @@ logical_function_t::logical_function_t(const sexp::stack_t &s)
 }
 
 
-bool logical_function_t::param2int(int *out) const
+bool param2int(const std::string &param, int *out)
 {
-    auto splitted = util::split(param(), ":");
+    auto splitted = util::split(param, ":");
     for (auto it = splitted.begin(); it != splitted.end(); ++it)
     {
         if (_sscanf(it->c_str(), "%d", out) == 1)
@@ -117,9 +117,9 @@ bool logical_function_t::param2int(int *out) const
 }
 
 
-bool logical_function_t::param2double(double *out) const
+bool param2double(const std::string &param, double *out)
 {
-    auto splitted = util::split(param(), ":");
+    auto splitted = util::split(param, ":");
     for (auto it = splitted.begin(); it != splitted.end(); ++it)
     {
         if (_sscanf(it->c_str(), "%lf", out) == 1)
@@ -129,6 +129,43 @@ bool logical_function_t::param2double(double *out) const
 }
 
 
+/** The body of logical_function_t::scan_parameter,
+ *  which is shared with axiom_view_t::scan_parameter. */
+static bool scan_parameter_v(
+    const std::string &param, const std::string &format, va_list arg)
+{
+    if (param.empty()) return "";
+
+    int idx1(1), idx2;
+    while (idx1 > 0)
+    {
+        va_list arg_copied;
+        idx2 = param.find(':');
+
+        va_copy(arg_copied, arg);
+        int ret = _vsscanf(
+            param.substr(idx1, idx2 - idx1).c_str(), format.c_str(), arg_copied);
+        va_end(arg_copied);
+
+        if (ret != EOF) return true;
+        idx1 = idx2 + 1;
+    }
+    return false;
+}
+
+
+bool logical_function_t::param2int(int *out) const
+{
+    return lf::param2int(param(), out);
+}
+
+
+bool logical_function_t::param2double(double *out) const
+{
+    return lf::param2double(param(), out);
+}
+
+
 bool logical_function_t::do_include(const literal_t& lit) const
 {
     auto my_literals(get_all_literals());
@@ -161,23 +198,12 @@ bool logical_function_t::find_parameter(const std::string &query) const
 
 bool logical_function_t::scan_parameter(const std::string &format, ...) const
 {
-    if (m_param.empty()) return "";
-
-    int idx1(1), idx2;
-    while (idx1 > 0)
-    {
-        va_list arg;
-        idx2 = m_param.find(':');
-
-        va_start(arg, format);
-        int ret = _vsscanf(
-            m_param.substr(idx1, idx2 - idx1).c_str(), format.c_str(), arg);
-        va_end(arg);
+    va_list arg;
+    va_start(arg, format);
+    bool out = scan_parameter_v(m_param, format, arg);
+    va_end(arg);
 
-        if (ret != EOF) return true;
-        idx1 = idx2 + 1;
-    }
-    return false;
+    return out;
 }
 
 
@@ -298,7 +324,7 @@ bool logical_function_t::is_valid_as_argument_set() const
         return false;
     else
     {
-        const std::vector<term_t> &terms(m_literal.terms);
+        const term_array_t &terms(m_literal.terms);
 
         for (auto it_term = terms.begin(); it_term != terms.end(); ++it_term)
         {
@@ -542,6 +568,122 @@ void logical_function_t::add_branch(const logical_function_t &lf)
 }
 
 
+axiom_view_t::axiom_view_t(const axiom_t &ax)
+    : id(ax.id), name(ax.name), m_operator(OPR_UNDERSPECIFIED),
+      m_params(1, ax.func.param()), m_num_lhs(0)
+{
+    if (ax.func.branches().size() != 2) return;
+
+    std::vector<const logical_function_t*> lhs, rhs;
+    ax.func.branch(0).enumerate_literal_branches(&lhs);
+    ax.func.branch(1).enumerate_literal_branches(&rhs);
+
+    m_literals.reserve(lhs.size() + rhs.size());
+    m_params.reserve(1 + lhs.size() + rhs.size());
+
+    for (auto br : lhs)
+    {
+        m_literals.push_back(br->literal());
+        m_params.push_back(br->param());
+    }
+    for (auto br : rhs)
+    {
+        m_literals.push_back(br->literal());
+        m_params.push_back(br->param());
+    }
+
+    m_num_lhs = lhs.size();
+    m_operator =
+        ax.func.is_operator(OPR_IMPLICATION) ? OPR_IMPLICATION :
+        ax.func.is_operator(OPR_PARAPHRASE) ? OPR_PARAPHRASE : OPR_INCONSISTENT;
+}
+
+
+size_t axiom_view_t::read_binary(const char *bin)
+{
+    size_t n(0);
+    int i_buf;
+
+    m_literals.clear();
+    m_params.assign(1, std::string());
+
+    n += util::binary_to_num(bin, &i_buf);
+    m_operator = static_cast<logical_operator_t>(i_buf);
+
+    switch (m_operator)
+    {
+    case OPR_IMPLICATION:
+    case OPR_PARAPHRASE:
+    case OPR_INCONSISTENT:
+        n += read_branch(bin + n);
+        m_num_lhs = m_literals.size();
+        n += read_branch(bin + n);
+        break;
+    default:
+        throw phillip_exception_t("Invalid operator occured.");
+    }
+
+    n += util::binary_to_string(bin + n, &m_params.front());
+    n += util::binary_to_string(bin + n, &name);
+
+    return n;
+}
+
+
+size_t axiom_view_t::read_branch(const char *bin)
+{
+    size_t n(0);
+    int i_buf;
+
+    n += util::binary_to_num(bin, &i_buf);
+
+    switch (static_cast<logical_operator_t>(i_buf))
+    {
+    case OPR_LITERAL:
+        m_literals.push_back(literal_t());
+        n += m_literals.back().read_binary(bin + n);
+        m_params.push_back(std::string());
+        n += util::binary_to_string(bin + n, &m_params.back());
+        return n;
+    case OPR_AND:
+    case OPR_OR:
+        n += util::binary_to_num(bin + n, &i_buf);
+        for (int i = 0; i < i_buf; ++i)
+            n += read_branch(bin + n);
+        break;
+    case OPR_IMPLICATION:
+    case OPR_PARAPHRASE:
+    case OPR_INCONSISTENT:
+        n += read_branch(bin + n);
+        n += read_branch(bin + n);
+        break;
+    case OPR_UNIPP:
+        n += read_branch(bin + n);
+        break;
+    default:
+        throw phillip_exception_t("Invalid operator occured.");
+    }
+
+    // SKIP THE PARAMETER OF THE BRANCH, WHICH IS NOT USED.
+    unsigned char size;
+    std::memcpy(&size, bin + n, sizeof(unsigned char));
+    n += sizeof(unsigned char) + size;
+
+    return n;
+}
+
+
+bool axiom_view_t::scan_parameter(const std::string &format, ...) const
+{
+    va_list arg;
+    va_start(arg, format);
+    bool out = scan_parameter_v(param(), format, arg);
+    va_end(arg);
+
+    return out;
+}
+
+
 void parse(const std::string &str, std::list<logical_function_t> *out)
 {
     std::stringstream ss(str);
@@ -128,6 +128,82 @@ struct axiom_t
 };
 
 
+/** A read-only and flat representation of an axiom.
+ *  All literals in the axiom are stored in one array, where those in LHS
+ *  precede those in RHS, together with parameters of them.
+ *  This can be decoded directly from the binary in the knowledge-base
+ *  without building the tree of logical_function_t. */
+class axiom_view_t
+{
+public:
+    /** A range of literals in an axiom. */
+    class span_t
+    {
+    public:
+        span_t(const literal_t *begin, const literal_t *end)
+            : m_begin(begin), m_end(end) {}
+
+        inline const literal_t* begin() const { return m_begin; }
+        inline const literal_t* end() const { return m_end; }
+        inline size_t size() const { return m_end - m_begin; }
+        inline bool empty() const { return m_begin == m_end; }
+        /** Throws std::out_of_range if i is not less than size(), as std::vector does. */
+        inline const literal_t& at(size_t i) const;
+        inline const literal_t& operator[](size_t i) const { return m_begin[i]; }
+
+    private:
+        const literal_t *m_begin, *m_end;
+    };
+
+    inline axiom_view_t();
+
+    /** Flattens an axiom which has been decoded as a tree. */
+    axiom_view_t(const axiom_t &ax);
+
+    /** Decodes an axiom from the binary, which consists of
+     *  the output of logical_function_t::write_binary and the name.
+     *  @return The size of the binary read. */
+    size_t read_binary(const char *bin);
+
+    inline bool is_operator(logical_operator_t opr) const { return m_operator == opr; }
+
+    inline span_t lhs() const;
+    inline span_t rhs() const;
+
+    /** Returns the parameter of the whole axiom. */
+    inline const std::string& param() const { return m_params.front(); }
+
+    /** Returns the parameter of the i-th literal in LHS or RHS. */
+    inline const std::string& lhs_param(size_t i) const;
+    inline const std::string& rhs_param(size_t i) const;
+
+    /** Scans the parameter of the whole axiom
+     *  in the same way as logical_function_t::scan_parameter. */
+    bool scan_parameter(const std::string &format, ...) const;
+
+    axiom_id_t id;
+    std::string name;
+
+private:
+    /** Appends literals in a branch in the binary and their parameters. */
+    size_t read_branch(const char *bin);
+
+    logical_operator_t m_operator;
+    std::vector<literal_t> m_literals;
+
+    /** The parameter of the axiom, followed by those of literals. */
+    std::vector<std::string> m_params;
+
+    size_t m_num_lhs;
+};
+
+
+/** Reads the first field of param, which is split by ':', as a number.
+ *  @return Whether any field can be read. */
+bool param2int(const std::string &param, int *out);
+bool param2double(const std::string &param, double *out);
+
+
 /** Parses given string as S-expression and returns the result of parsing. */
 void parse(const std::string &str, std::list<logical_function_t> *out);
 
@@ -82,6 +82,45 @@ logical_function_t::get_all_literals() const
 }
 
 
+inline const literal_t& axiom_view_t::span_t::at(size_t i) const
+{
+    if (i >= size())
+        throw std::out_of_range("axiom_view_t::span_t::at");
+    return m_begin[i];
+}
+
+
+inline axiom_view_t::axiom_view_t()
+    : id(-1), m_operator(OPR_UNDERSPECIFIED), m_params(1), m_num_lhs(0)
+{}
+
+
+inline axiom_view_t::span_t axiom_view_t::lhs() const
+{
+    const literal_t *begin = m_literals.data();
+    return span_t(begin, begin + m_num_lhs);
+}
+
+
+inline axiom_view_t::span_t axiom_view_t::rhs() const
+{
+    const literal_t *begin = m_literals.data();
+    return span_t(begin + m_num_lhs, begin + m_literals.size());
+}
+
+
+inline const std::string& axiom_view_t::lhs_param(size_t i) const
+{
+    return m_params.at(1 + i);
+}
+
+
+inline const std::string& axiom_view_t::rhs_param(size_t i) const
+{
+    return m_params.at(1 + m_num_lhs + i);
+}
+
+
 }
 
 }
@@ -159,7 +159,26 @@ void phillip_main_t::execute_enumerator(
     if ((*out_lhs) != NULL) delete m_lhs;
 
     auto begin = std::chrono::system_clock::now();
-    (*out_lhs) = m_lhs_enumerator->execute();
+    const std::string &path_bin_in = param("path_lhs_bin_in");
+    bool is_loaded(false);
+
+    // LOADS THE PROOF-GRAPH WRITTEN BEFOREHAND INSTEAD OF ENUMERATING IT.
+    if (not path_bin_in.empty())
+    {
+        (*out_lhs) = new pg::proof_graph_t(this, m_input->name);
+        is_loaded = (*out_lhs)->read_binary(path_bin_in);
+
+        if (not is_loaded)
+        {
+            util::print_warning_fmt(
+                "Cannot find the latent-hypotheses-set of \"%s\" in \"%s\".",
+                m_input->name.c_str(), path_bin_in.c_str());
+            delete (*out_lhs);
+        }
+    }
+
+    if (not is_loaded)
+        (*out_lhs) = m_lhs_enumerator->execute();
     (*out_time) = util::duration_time(begin);
 
     IF_VERBOSE_2(
@@ -177,6 +196,17 @@ void phillip_main_t::execute_enumerator(
             delete fo;
         }
     }
+
+    if (not is_loaded)
+    {
+        std::ios::openmode mode = std::ios::out | std::ios::app | std::ios::binary;
+        std::ofstream *fo = _open_file(param("path_lhs_bin_out"), mode);
+        if (fo != NULL)
+        {
+            m_lhs->write_binary(fo);
+            delete fo;
+        }
+    }
 }
 
 
@@ -326,6 +356,14 @@ void phillip_main_t::write_header() const
     f_write("path_sol_out");
     f_write("path_out");
     write(&std::cout);
+
+    // BINARIES OF LATENT-HYPOTHESES-SETS ARE APPENDED ON EACH INFERENCE.
+    if (param("path_lhs_bin_out") != param("path_lhs_bin_in"))
+    {
+        std::ofstream *fo = _open_file(
+            param("path_lhs_bin_out"), std::ios::out | std::ios::trunc | std::ios::binary);
+        if (fo != NULL) delete fo;
+    }
 }
 
 
@@ -296,6 +296,9 @@ inline void phillip_main_t::reset_for_inference()
     m_time_for_infer = 0.0f;
 
     m_sol.clear();
+
+    // IDS OF UNKNOWN TERMS IN THE PREVIOUS INFERENCE ARE NO LONGER USED.
+    string_hash_t::reset_unknown_hash_count();
 }
 
 
@@ -1,6 +1,11 @@
 /* -*- coding: utf-8 -*- */
 
 #include <algorithm>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
 
 #include "./processor.h"
 #include "./phillip.h"
@@ -73,9 +78,26 @@ void compile_kb_t::prepare()
 
 
 void compile_kb_t::process( const sexp::reader_t *reader )
-{    
+{
+    std::list<statement_t> statements;
+    parse(reader, &statements);
+
+    for (auto st = statements.begin(); st != statements.end(); ++st)
+        insert(*st);
+}
+
+
+void compile_kb_t::parse(const sexp::reader_t *reader, std::list<statement_t> *out)
+{
     const sexp::stack_t *stack(reader->get_stack());
-    kb::knowledge_base_t *_kb = kb::knowledge_base_t::instance();
+
+    auto add_stop_word = [out](const arity_t &a)
+    {
+        out->push_back(statement_t());
+        out->back().type = statement_t::STATEMENT_STOP_WORD;
+        out->back().name = a;
+        IF_VERBOSE_FULL("Added stop-word assertion: " + a);
+    };
 
     if (stack->is_functor("ASSERT"))
     {
@@ -86,11 +108,7 @@ void compile_kb_t::process( const sexp::reader_t *reader )
         if (stack->children.at(0)->get_string() == "stopword")
         {
             for (int i = 1; i < stack->children.size(); ++i)
-            {
-                arity_t a = stack->children.at(i)->get_string();
-                kb::kb()->assert_stop_word(a);
-                IF_VERBOSE_FULL("Added stop-word assertion: " + a);
-            }
+                add_stop_word(stack->children.at(i)->get_string());
         }
     }
     
@@ -113,52 +131,68 @@ void compile_kb_t::process( const sexp::reader_t *reader )
         (idx_lf >= 0 or idx_para >= 0 or idx_inc >= 0 or idx_pp >= 0 or idx_as >= 0 or idx_assert >= 0),
         (*reader), "No logical connectors found." );
 
-    std::string name;
+    statement_t st;
     if (idx_name >= 0)
-        name = stack->children.at(idx_name)->children.at(1)->get_string();
+        st.name = stack->children.at(idx_name)->children.at(1)->get_string();
 
     if (idx_lf >= 0 or idx_para >= 0)
     {
+        // EACH THREAD REUSES ITS OWN BUFFER ON THE HEAP, SO THAT WORKER THREADS
+        // OF parallel_kb_compiler_t DO NOT NEED LARGE STACKS
+        // AND NO BUFFER IS ALLOCATED FOR EACH AXIOM.
+        const int SIZE(512 * 512);
+        static thread_local std::vector<char> buffer(SIZE);
+
         index_t idx = std::max(idx_lf, idx_para);
-        lf::logical_function_t func(*stack->children[idx]);
+        st.type = statement_t::STATEMENT_IMPLICATION;
+        st.func = lf::logical_function_t(*stack->children[idx]);
         _assert_syntax(
             (stack->children.at(idx)->children.size() >= 3), (*reader),
             "Function '=>' and '<=>' takes two arguments.");
         IF_VERBOSE_FULL(
             ((idx_lf >= 0) ? "Added implication: " : "Added paraphrase") +
             stack->to_string());
-        _kb->insert_implication(func, name);
+
+        // ENCODES THE AXIOM HERE, SO THAT IT IS DONE ON WORKER THREADS.
+        size_t size = st.func.write_binary(&buffer[0]);
+        _assert_syntax(
+            (size < buffer.size()), (*reader), "The axiom is too large to be compiled.");
+        st.bin.assign(buffer.begin(), buffer.begin() + size);
+        out->push_back(st);
     }
     else if (idx_inc >= 0)
     {
-        lf::logical_function_t func(*stack->children[idx_inc]);
+        st.type = statement_t::STATEMENT_INCONSISTENCY;
+        st.func = lf::logical_function_t(*stack->children[idx_inc]);
         _assert_syntax(
             (stack->children.at(idx_inc)->children.size() >= 3), (*reader),
             "Function 'xor' takes two arguments.");
         IF_VERBOSE_FULL("Added inconsistency: " + stack->to_string());
-        _kb->insert_inconsistency(func);
+        out->push_back(st);
     }
     else if (idx_pp >= 0)
     {
-        lf::logical_function_t func(*stack->children[idx_pp]);
+        st.type = statement_t::STATEMENT_UNIPP;
+        st.func = lf::logical_function_t(*stack->children[idx_pp]);
         _assert_syntax(
             (stack->children.at(idx_pp)->children.size() >= 2), (*reader),
             "Function 'unipp' takes one argument.");
         IF_VERBOSE_FULL("Added unification-postponement: " + stack->to_string());
-        _kb->insert_unification_postponement(func);
+        out->push_back(st);
     }
     else if (idx_as >= 0)
     {
-        lf::logical_function_t func(*stack->children[idx_as]);
+        st.type = statement_t::STATEMENT_ARGUMENT_SET;
+        st.func = lf::logical_function_t(*stack->children[idx_as]);
         if (phillip_main_t::verbose() == FULL_VERBOSE)
         {
-            const std::vector<term_t> &terms = func.literal().terms;
+            const term_array_t &terms = st.func.literal().terms;
             std::string disp;
             for (auto it = terms.begin(); it != terms.end(); ++it)
                 disp += (it != terms.begin() ? ", " : "") + it->string();
             util::print_console("Added argument-set: {" + disp + "}");
         }
-        _kb->insert_argument_set(func);
+        out->push_back(st);
     }
     else if (idx_assert >= 0)
     {
@@ -171,16 +205,37 @@ void compile_kb_t::process( const sexp::reader_t *reader )
                 target->children.size() > 2, (*reader),
                 "Function 'assert stopword' takes at least one argument.");
             for (int i = 2; i < target->children.size(); ++i)
-            {
-                arity_t a = target->children.at(i)->get_string();
-                kb::kb()->assert_stop_word(a);
-                IF_VERBOSE_FULL("Added stop-word assertion: " + a);
-            }
+                add_stop_word(target->children.at(i)->get_string());
         }
     }
 }
 
 
+void compile_kb_t::insert(const statement_t &st)
+{
+    kb::knowledge_base_t *_kb = kb::knowledge_base_t::instance();
+
+    switch (st.type)
+    {
+    case statement_t::STATEMENT_IMPLICATION:
+        _kb->insert_implication(st.func, st.name, &st.bin);
+        break;
+    case statement_t::STATEMENT_INCONSISTENCY:
+        _kb->insert_inconsistency(st.func);
+        break;
+    case statement_t::STATEMENT_UNIPP:
+        _kb->insert_unification_postponement(st.func);
+        break;
+    case statement_t::STATEMENT_ARGUMENT_SET:
+        _kb->insert_argument_set(st.func);
+        break;
+    case statement_t::STATEMENT_STOP_WORD:
+        _kb->assert_stop_word(st.name);
+        break;
+    }
+}
+
+
 void compile_kb_t::quit()
 {}
 
@@ -288,6 +343,143 @@ void processor_t::include( const sexp::reader_t *reader )
 }
 
 
+void parallel_kb_compiler_t::process(std::vector<std::string> inputs)
+{
+    if (inputs.empty())
+        inputs.push_back("-");
+
+    IF_VERBOSE_FULL(
+        "parallel_kb_compiler_t::process: inputs={" +
+        util::join(inputs.begin(), inputs.end(), ", ") + "}");
+
+    struct parsed_input_t
+    {
+        parsed_input_t() : is_done(false) {}
+
+        std::list<compile_kb_t::statement_t> statements;
+        std::exception_ptr error;
+        bool is_done;
+    };
+
+    std::vector<parsed_input_t> parsed(inputs.size());
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::atomic<size_t> next(0);
+    std::vector<std::thread> worker;
+    int num_thread = std::min<int>(inputs.size(), m_num_threads);
+    if (num_thread < 1) num_thread = 1;
+
+    for (int th_id = 0; th_id < num_thread; ++th_id)
+    {
+        worker.emplace_back([&]()
+        {
+            for (size_t i = next++; i < inputs.size(); i = next++)
+            {
+                std::list<compile_kb_t::statement_t> statements;
+                std::exception_ptr error;
+
+                try
+                {
+                    parse(inputs.at(i), &statements);
+                }
+                catch (...)
+                {
+                    error = std::current_exception();
+                }
+
+                std::lock_guard<std::mutex> lock(mutex);
+                parsed[i].statements.swap(statements);
+                parsed[i].error = error;
+                parsed[i].is_done = true;
+                cond.notify_all();
+            }
+        });
+    }
+
+    /* STATEMENTS ARE INSERTED BY THIS THREAD IN THE ORDER OF INPUTS,
+     * SO THAT AXIOM-IDS AND ARITY-IDS DO NOT DEPEND ON THE SCHEDULING. */
+    std::exception_ptr error;
+
+    for (size_t i = 0; i < inputs.size() and not error; ++i)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cond.wait(lock, [&]() { return parsed[i].is_done; });
+        lock.unlock();
+
+        if (parsed[i].error)
+        {
+            error = parsed[i].error;
+            next = inputs.size(); // STOP PARSING REMAINING INPUTS.
+        }
+        else
+        {
+            for (const auto &st : parsed[i].statements)
+                compile_kb_t::insert(st);
+            parsed[i].statements.clear();
+            IF_VERBOSE_2("  compiled " + inputs.at(i));
+        }
+    }
+
+    for (auto &t : worker) t.join();
+
+    if (error)
+        std::rethrow_exception(error);
+}
+
+
+void parallel_kb_compiler_t::parse(
+    const std::string &input_path,
+    std::list<compile_kb_t::statement_t> *out) const
+{
+    std::istream *p_is(&std::cin);
+    std::ifstream file;
+    std::string filename;
+
+    if (input_path != "-")
+    {
+        file.open(input_path.c_str());
+        p_is = &file;
+
+        if (file.fail())
+            throw phillip_exception_t("File not found: " + input_path);
+
+        filename = input_path.substr(input_path.rfind('/') + 1);
+    }
+    else
+        filename = "stdin";
+
+    sexp::reader_t reader(*p_is, filename);
+
+    for (; not reader.is_end(); reader.read())
+    {
+        const sexp::stack_t &stack(*reader.get_stack());
+
+        compile_kb_t::parse(&reader, out);
+
+        if (stack.is_functor("include"))
+        {
+            const sexp::stack_t& arg(*stack.children.at(1));
+            _assert_syntax(
+                (arg.type == sexp::stack_t::STRING_STACK),
+                reader, "what is included should be a string.");
+            parse(arg.get_string(), out);
+        }
+    }
+
+    if (input_path != "-") file.close();
+
+    if (reader.get_queue().size() != 1)
+    {
+        std::string disp = util::format(
+            "Syntax error: too few parentheses. Around here, or line %d"
+            " (typically the expression followed by this): %s",
+            reader.get_line_num(),
+            reader.get_stack()->to_string().c_str());
+        throw phillip_exception_t(disp);
+    }
+}
+
+
 
 }
 
@@ -42,9 +42,58 @@ private:
 class compile_kb_t : public component_t
 {
 public:
+    /** A statement for knowledge base, which is parsed from input. */
+    struct statement_t
+    {
+        enum statement_type_e
+        {
+            STATEMENT_IMPLICATION, STATEMENT_INCONSISTENCY,
+            STATEMENT_UNIPP, STATEMENT_ARGUMENT_SET, STATEMENT_STOP_WORD
+        };
+
+        statement_type_e type;
+        lf::logical_function_t func;
+        std::string name; /// The name of axiom, or the arity of stop-word.
+        std::vector<char> bin; /// The binary of func, encoded on parsing.
+    };
+
     virtual void prepare();
     virtual void process(const sexp::reader_t*);
     virtual void quit();
+
+    /** Parses the current expression in reader into statements.
+     *  This method does not touch knowledge base,
+     *  so that it can be called from multiple threads. */
+    static void parse(const sexp::reader_t*, std::list<statement_t> *out);
+
+    /** Inserts a parsed statement to knowledge base. */
+    static void insert(const statement_t&);
+};
+
+
+/** A class to compile knowledge base from multiple inputs in parallel.
+ *  Each input is parsed on a worker thread, and the parsed statements
+ *  are inserted to knowledge base by one thread in the order of inputs.
+ *  Therefore, the compiled knowledge base is identical to that with compile_kb_t.
+ *  Note that parallelism is per input file only:
+ *  a single input and files included from it are parsed on one thread. */
+class parallel_kb_compiler_t
+{
+public:
+    parallel_kb_compiler_t(int num_threads) : m_num_threads(num_threads) {}
+
+    /** Compiles inputs.
+     *  Standard input is regarded as input when inputs is empty.
+     *  @param inputs List of filename of input file. */
+    void process(std::vector<std::string> inputs);
+
+private:
+    /** Parses an input file and included ones recursively. */
+    void parse(
+        const std::string &input_path,
+        std::list<compile_kb_t::statement_t> *out) const;
+
+    int m_num_threads;
 };
 
 
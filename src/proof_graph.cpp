@@ -5,6 +5,10 @@
 #include <cassert>
 #include <set>
 #include <iterator>
+#include <climits>
+#include <thread>
+#include <memory>
+#include <mutex>
 
 #include "./proof_graph.h"
 #include "./phillip.h"
@@ -18,19 +22,166 @@ namespace pg
 
 
 
+void node_set_t::insert(node_idx_t idx)
+{
+    assert(idx >= 0);
+
+    node_idx_t chunk = idx / BITS_PER_CHUNK;
+    auto found = find_chunk(chunk);
+    unsigned long long bit = 1ull << (idx % BITS_PER_CHUNK);
+
+    if (found != m_chunks.end() and found->index == chunk)
+        m_chunks[found - m_chunks.begin()].bits |= bit;
+    else
+    {
+        chunk_t c = { chunk, bit };
+        m_chunks.insert(m_chunks.begin() + (found - m_chunks.begin()), c);
+    }
+}
+
+
+void node_set_t::insert(const node_set_t &x)
+{
+    if (x.empty()) return;
+    if (empty())
+    {
+        m_chunks = x.m_chunks;
+        return;
+    }
+
+    std::vector<chunk_t> merged;
+    merged.reserve(m_chunks.size() + x.m_chunks.size());
+
+    auto it1 = m_chunks.cbegin(), it2 = x.m_chunks.cbegin();
+    while (it1 != m_chunks.cend() or it2 != x.m_chunks.cend())
+    {
+        if (it2 == x.m_chunks.cend() or
+            (it1 != m_chunks.cend() and it1->index < it2->index))
+            merged.push_back(*(it1++));
+        else if (it1 == m_chunks.cend() or it2->index < it1->index)
+            merged.push_back(*(it2++));
+        else
+        {
+            chunk_t c = { it1->index, it1->bits | it2->bits };
+            merged.push_back(c);
+            ++it1;
+            ++it2;
+        }
+    }
+
+    m_chunks.swap(merged);
+}
+
+
+bool node_set_t::has_intersection(const node_set_t &x) const
+{
+    auto it1 = m_chunks.cbegin(), it2 = x.m_chunks.cbegin();
+    while (it1 != m_chunks.cend() and it2 != x.m_chunks.cend())
+    {
+        if (it1->index < it2->index) ++it1;
+        else if (it2->index < it1->index) ++it2;
+        else
+        {
+            if ((it1->bits & it2->bits) != 0) return true;
+            ++it1;
+            ++it2;
+        }
+    }
+    return false;
+}
+
+
+node_set_t node_set_t::intersection(const node_set_t &x) const
+{
+    node_set_t out;
+    auto it1 = m_chunks.cbegin(), it2 = x.m_chunks.cbegin();
+    while (it1 != m_chunks.cend() and it2 != x.m_chunks.cend())
+    {
+        if (it1->index < it2->index) ++it1;
+        else if (it2->index < it1->index) ++it2;
+        else
+        {
+            chunk_t c = { it1->index, it1->bits & it2->bits };
+            if (c.bits != 0) out.m_chunks.push_back(c);
+            ++it1;
+            ++it2;
+        }
+    }
+    return out;
+}
+
+
+node_set_t node_set_t::difference(const node_set_t &x) const
+{
+    node_set_t out;
+    auto it2 = x.m_chunks.cbegin();
+    for (const auto &c1 : m_chunks)
+    {
+        while (it2 != x.m_chunks.cend() and it2->index < c1.index) ++it2;
+
+        chunk_t c = c1;
+        if (it2 != x.m_chunks.cend() and it2->index == c1.index)
+            c.bits &= ~(it2->bits);
+        if (c.bits != 0) out.m_chunks.push_back(c);
+    }
+    return out;
+}
+
+
+size_t node_set_t::size() const
+{
+    size_t out(0);
+    for (const auto &c : m_chunks)
+    {
+#ifdef _WIN32
+        for (unsigned long long bits = c.bits; bits != 0; bits &= bits - 1)
+            ++out;
+#else
+        out += __builtin_popcountll(c.bits);
+#endif
+    }
+    return out;
+}
+
+
+bool node_set_t::read_binary(util::binary_reader_t *rd, index_t limit)
+{
+    rd->read_array(&m_chunks);
+
+    // CHUNKS MUST BE NON-EMPTY AND IN STRICTLY ASCENDING ORDER.
+    for (size_t i = 0; i < m_chunks.size(); ++i)
+    {
+        const chunk_t &c = m_chunks[i];
+        if (c.index < 0 or c.bits == 0) return false;
+        if (i > 0 and m_chunks[i - 1].index >= c.index) return false;
+    }
+
+    // ONLY THE LAST CHUNK CAN HAVE THE LARGEST MEMBER.
+    if (not m_chunks.empty())
+    {
+        const chunk_t &c = m_chunks.back();
+        if (c.index >= (limit + BITS_PER_CHUNK - 1) / BITS_PER_CHUNK) return false;
+
+        index_t offset = limit - c.index * BITS_PER_CHUNK;
+        if (offset < BITS_PER_CHUNK and (c.bits >> offset) != 0) return false;
+    }
+
+    return true;
+}
+
+
 node_t::node_t(
     const proof_graph_t *graph,
     const literal_t &lit, node_type_e type, node_idx_t idx,
     depth_t depth, const hash_set<node_idx_t> &parents)
     : m_type(type), m_literal(lit), m_index(idx),
     m_depth(depth), m_arity_id(kb::INVALID_ARITY_ID),
-    m_master_hypernode_idx(-1), m_parents(parents), m_ancestors(parents)
+    m_master_hypernode_idx(-1), m_parents(parents)
 {
+    m_ancestors.insert(parents.begin(), parents.end());
+
     for (auto p : m_parents)
-    {
-        const hash_set<node_idx_t> &ancs = graph->node(p).ancestors();
-        m_ancestors.insert(ancs.begin(), ancs.end());
-    }
+        m_ancestors.insert(graph->node(p).ancestors());
 
     for (auto idx : m_parents)
     {
@@ -39,14 +190,11 @@ node_t::node_t(
         m_relatives.insert(bros.begin(), bros.end());
 
         for (auto br : bros)
-        {
-            const hash_set<node_idx_t> &ancs = graph->node(br).ancestors();
-            m_ancestors.insert(ancs.begin(), ancs.end());
-        }
+            m_ancestors.insert(graph->node(br).ancestors());
     }
 
     if (not m_literal.is_equality())
-        m_arity_id = kb::kb()->search_arity_id(m_literal.get_arity());
+        m_arity_id = kb::kb()->search_arity_id(m_literal);
 }
 
 
@@ -186,23 +334,26 @@ void proof_graph_t::chain_candidate_generator_t::init(node_idx_t idx)
 
     if (m_pivot >= 0)
     {
-        std::list<kb::arity_pattern_t> patterns;
+        const kb::knowledge_base_t *base = kb::kb();
         kb::arity_id_t id_pivot = m_graph->node(m_pivot).arity_id();
 
-        kb::kb()->search_arity_patterns(id_pivot, &patterns);
-        m_patterns.insert(patterns.begin(), patterns.end());
+        base->search_arity_patterns(id_pivot, &m_patterns);
 
         hash_map<kb::arity_id_t, float> soft_unifiable_arities;
 
-        kb::kb()->category_table()->gets(id_pivot, &soft_unifiable_arities);
+        base->category_table()->gets(id_pivot, &soft_unifiable_arities);
 
         for (auto p : soft_unifiable_arities)
         if (p.second >= 0.0 and
             p.second < m_graph->threshold_distance_for_soft_unifying())
-        {
-            kb::kb()->search_arity_patterns(p.first, &patterns);
-            m_patterns.insert(patterns.begin(), patterns.end());
-        }
+            base->search_arity_patterns(p.first, &m_patterns);
+
+        // PATTERNS ARE ENUMERATED IN THE ORDER OF THEIR CONTENTS.
+        std::sort(m_patterns.begin(), m_patterns.end(),
+            [base](kb::arity_pattern_id_t a, kb::arity_pattern_id_t b)
+            { return base->arity_pattern_precedes(a, b); });
+        m_patterns.erase(
+            std::unique(m_patterns.begin(), m_patterns.end()), m_patterns.end());
     }
 
     m_pt_iter = m_patterns.begin();
@@ -232,119 +383,253 @@ void proof_graph_t::chain_candidate_generator_t::enumerate()
 
     if (end()) return;
 
-    hash_map<kb::arity_id_t, hash_set<node_idx_t>> a2ns;
-    std::list<std::list<node_idx_t> > node_arrays;
+    m_pattern = kb::kb()->get_arity_pattern(*m_pt_iter);
+    const index_t n = m_pattern.num_arities();
+
+    /** A hard-term constraint, which requires
+     *  the term1-th term of slot1 to equal the term2-th term of slot2. */
+    struct hard_term_t
+    {
+        index_t slot1, slot2;
+        term_idx_t term1, term2;
+    };
+
+    /** A step of the join plan, which fills a slot.
+     *  If key is not NULL, candidates are looked up by the term
+     *  which the constraint requires, instead of scanning the slot. */
+    struct step_t
+    {
+        index_t slot;
+        const hard_term_t *key;
+        std::vector<const hard_term_t*> checks;
+    };
+
+    // COLLECTS NODES WHICH CAN FILL EACH SLOT, IN ASCENDING ORDER.
+    // NODES OF THE SAME ARITY ARE REFERRED TO WITHOUT COPYING,
+    // AND ONLY ARITIES OF SOFT-UNIFIABLE LITERALS NEED THEIR OWN LISTS.
+    hash_map<kb::arity_id_t, std::vector<node_idx_t> > softs;
+    std::vector<const std::vector<node_idx_t>*> slot_nodes(n, NULL);
 
-    // CONSTRUCTS a2ns
-    for (auto a : kb::arities(*m_pt_iter))
-    if (a2ns.count(a) == 0)
+    for (size_t j = 0; j < m_pattern.num_soft_unifiable_literals(); ++j)
     {
+        kb::arity_id_t a = m_pattern.arity(m_pattern.soft_unifiable_literal_index(j));
+        if (softs.count(a) > 0) continue;
+
+        hash_set<node_idx_t> ns;
+        m_graph->enumerate_nodes_softly_unifiable(kb::kb()->search_arity(a), &ns);
+
         auto found = m_graph->search_nodes_with_arity(a);
         if (found != NULL)
-            a2ns.insert(std::make_pair(a, *found));
+            ns.insert(found->begin(), found->end());
+
+        std::vector<node_idx_t> &v = softs[a];
+        v.assign(ns.begin(), ns.end());
+        std::sort(v.begin(), v.end());
     }
 
-    // EXPANDS a2ns WITH SOFT-UNIFIABLE NODES
-    for (auto i : kb::soft_unifiable_literal_indices(*m_pt_iter))
+    for (index_t i = 0; i < n; ++i)
     {
-        kb::arity_id_t a = kb::arities(*m_pt_iter).at(i);
-        hash_set<node_idx_t> ns;
+        kb::arity_id_t a = m_pattern.arity(i);
+        auto found = softs.find(a);
+        slot_nodes[i] = (found != softs.end()) ?
+            &found->second : m_graph->search_nodes_with_arity(a);
 
-        m_graph->enumerate_nodes_softly_unifiable(kb::kb()->search_arity(a), &ns);
-        if (not ns.empty())
-            a2ns[a].insert(ns.begin(), ns.end());
+        // IF THERE IS A SLOT WHICH CANNOT BE FILLED, THEN ABORT.
+        if (slot_nodes[i] == NULL or slot_nodes[i]->empty()) return;
     }
 
-    // IF THERE IS A SLOT WHICH CANNOT BE FILLED, THEN ABORT.
+    std::vector<hard_term_t> hard_terms;
+    for (size_t i = 0; i < m_pattern.num_hard_terms(); ++i)
     {
-        hash_set<kb::arity_id_t> arity_set(
-            kb::arities(*m_pt_iter).begin(),
-            kb::arities(*m_pt_iter).end());
-        if (a2ns.size() < arity_set.size()) return;
+        auto p = m_pattern.hard_term(i);
+        hard_term_t h = { p.first.first, p.second.first, p.first.second, p.second.second };
+        hard_terms.push_back(h);
     }
 
-    // CONSTRUCTS hard_term_satisfiers,
-    // WHICH IS LISTS OF NODE-PAIR WHICH CAN SATISFY HARD-TERM CONSTRAINTS.
-    hash_map<index_t, hash_map<index_t, std::pair<term_idx_t, term_idx_t>>> hard_terms;
-    for (auto p : kb::hard_terms(*m_pt_iter))
-        hard_terms[p.second.first][p.first.first] =
-            std::make_pair(p.second.second, p.first.second);
-
-    hash_set<index_t> slots_pivot;
-    for (index_t i = 0; i < kb::arities(*m_pt_iter).size(); ++i)
+    std::vector<index_t> slots_pivot;
+    for (index_t i = 0; i < n; ++i)
     {
-        kb::arity_id_t id1 = kb::arities(*m_pt_iter).at(i);
+        kb::arity_id_t id1 = m_pattern.arity(i);
         kb::arity_id_t id2 = m_graph->node(m_pivot).arity_id();
 
         if (id1 == id2)
-            slots_pivot.insert(i);
+            slots_pivot.push_back(i);
         else
         {
             float dist = kb::kb()->category_table()->get(id1, id2);
             if (dist >= 0.0f and
                 dist < m_graph->threshold_distance_for_soft_unifying())
-                slots_pivot.insert(i);
+                slots_pivot.push_back(i);
         }
     }
     assert(not slots_pivot.empty());
 
-    // SUB-ROUTINE OF routine_recursive.
-    auto do_violate_hard_term =
-        [&, this](const std::vector<pg::node_idx_t> *nodes, index_t i) -> bool
+    std::vector<node_idx_t> nodes(n, -1);
+    std::vector<step_t> plan(n);
+    std::vector<char> is_filled(n);
+    std::vector<const node_idx_t*> iters(n), ends(n);
+    std::vector< std::vector<node_idx_t> > buffers(n);
+
+    auto term_at = [this](node_idx_t idx, term_idx_t i) -> const term_t*
     {
-        auto it = hard_terms.find(i);
-        
-        if (it != hard_terms.end())
-        for (auto p : it->second)
-        {
-            const literal_t &l1 = m_graph->node(nodes->at(i)).literal();
-            const literal_t &l2 = m_graph->node(nodes->at(p.first)).literal();
+        const literal_t &lit = m_graph->node(idx).literal();
+        return (i < lit.terms.size()) ? &lit.terms.at(i) : NULL;
+    };
 
-            return l1.terms.at(p.second.first) != l2.terms.at(p.second.second);
+    // RETURNS WHETHER THE NODE IN THE STEP SATISFIES EVERY HARD-TERM
+    // CONSTRAINT BETWEEN ITS SLOT AND SLOTS WHICH HAVE BEEN FILLED.
+    auto satisfy_hard_terms = [&](const step_t &st) -> bool
+    {
+        for (auto h : st.checks)
+        {
+            const term_t *t1 = term_at(nodes[h->slot1], h->term1);
+            const term_t *t2 = term_at(nodes[h->slot2], h->term2);
+            if (t1 == NULL or t2 == NULL or (*t1) != (*t2))
+                return false;
         }
-        
-        return false;
+        return true;
     };
 
-    std::function<void(std::vector<node_idx_t>*, index_t, index_t)> routine_recursive;
-    routine_recursive = [&, this](std::vector<pg::node_idx_t> *nodes, index_t i, index_t i_pivot)
+    // SETS CANDIDATES OF THE k-TH STEP.
+    auto open = [&](index_t k)
     {
-        if (i == i_pivot)
+        const step_t &st = plan[k];
+
+        if (k == 0)
         {
-            (*nodes)[i] = m_pivot;
-            
-            if (not do_violate_hard_term(nodes, i))
-            {
-                if (i < kb::arities(*m_pt_iter).size() - 1)
-                    routine_recursive(nodes, i + 1, i_pivot);
-                else
-                    m_targets.push_back(*nodes);
-            }
+            iters[k] = &m_pivot;
+            ends[k] = &m_pivot + 1;
+        }
+        else if (st.key == NULL)
+        {
+            iters[k] = &slot_nodes[st.slot]->front();
+            ends[k] = iters[k] + slot_nodes[st.slot]->size();
         }
         else
         {
-            const hash_set<node_idx_t> &ns =
-                a2ns.at(kb::arities(*m_pt_iter).at(i));
-            
-            for (auto n : ns)
+            // HASH-JOIN WITH THE FILLED SLOT ON THE SHARED HARD TERM.
+            bool is_first = (st.key->slot1 == st.slot);
+            index_t other = is_first ? st.key->slot2 : st.key->slot1;
+            term_idx_t i_this = is_first ? st.key->term1 : st.key->term2;
+            term_idx_t i_other = is_first ? st.key->term2 : st.key->term1;
+
+            std::vector<node_idx_t> &buf = buffers[k];
+            const std::vector<node_idx_t> &ns = *slot_nodes[st.slot];
+            const term_t *t = term_at(nodes[other], i_other);
+            const hash_set<node_idx_t> *found =
+                (t != NULL) ? m_graph->search_nodes_with_term(*t) : NULL;
+
+            buf.clear();
+            if (found != NULL)
+            for (auto idx : (*found))
             {
-                (*nodes)[i] = n;
+                const term_t *t2 = term_at(idx, i_this);
+                if (t2 != NULL and (*t2) == (*t) and
+                    std::binary_search(ns.begin(), ns.end(), idx))
+                    buf.push_back(idx);
+            }
+            std::sort(buf.begin(), buf.end());
 
-                if (not do_violate_hard_term(nodes, i))
+            iters[k] = buf.data();
+            ends[k] = buf.data() + buf.size();
+        }
+    };
+
+    for (size_t i_pt = 0; i_pt < slots_pivot.size(); ++i_pt)
+    {
+        index_t i_pivot = slots_pivot.at(i_pt);
+
+        // MAKES THE JOIN PLAN, WHICH FILLS THE PIVOT FIRST.
+        // THEN SLOTS JOINABLE WITH FILLED SLOTS ARE PREFERRED,
+        // AND SLOTS WITH FEWER CANDIDATES ARE PREFERRED AMONG THEM.
+        std::fill(is_filled.begin(), is_filled.end(), 0);
+        for (index_t k = 0; k < n; ++k)
+        {
+            step_t &st = plan[k];
+            st.slot = -1;
+            st.key = NULL;
+
+            if (k == 0)
+                st.slot = i_pivot;
+            else
+            {
+                size_t best_size(0);
+                for (index_t i = 0; i < n; ++i)
                 {
-                    if (i < kb::arities(*m_pt_iter).size() - 1)
-                        routine_recursive(nodes, i + 1, i_pivot);
-                    else
-                        m_targets.push_back(*nodes);
+                    if (is_filled[i]) continue;
+
+                    const hard_term_t *key = NULL;
+                    for (const auto &h : hard_terms)
+                    if (h.slot1 != h.slot2)
+                    if ((h.slot1 == i and is_filled[h.slot2]) or
+                        (h.slot2 == i and is_filled[h.slot1]))
+                    {
+                        key = &h;
+                        break;
+                    }
+
+                    size_t size = slot_nodes[i]->size();
+                    bool is_better =
+                        (st.slot < 0) or
+                        (key != NULL and st.key == NULL) or
+                        ((key != NULL) == (st.key != NULL) and size < best_size);
+
+                    if (is_better)
+                    {
+                        st.slot = i;
+                        st.key = key;
+                        best_size = size;
+                    }
                 }
             }
+
+            is_filled[st.slot] = 1;
+            st.checks.clear();
+            for (const auto &h : hard_terms)
+            if ((h.slot1 == st.slot and is_filled[h.slot2]) or
+                (h.slot2 == st.slot and is_filled[h.slot1]))
+                st.checks.push_back(&h);
         }
-    };
-    
-    std::vector<node_idx_t> nodes(kb::arities(*m_pt_iter).size(), -1);
 
-    for (auto i_pivot : slots_pivot)
-        routine_recursive(&nodes, 0, i_pivot);
+        // ENUMERATES TUPLES BY BACKTRACKING ON THE PLAN.
+        index_t k(0);
+        open(0);
+
+        while (true)
+        {
+            if (iters[k] == ends[k])
+            {
+                if (k == 0) break;
+                ++iters[--k];
+                continue;
+            }
+
+            const step_t &st = plan[k];
+            nodes[st.slot] = *iters[k];
+
+            if (not satisfy_hard_terms(st))
+            {
+                ++iters[k];
+                continue;
+            }
+
+            if (k + 1 < n)
+            {
+                open(++k);
+                continue;
+            }
+
+            // A TUPLE WHICH HAS THE PIVOT IN AN EARLIER PIVOT-SLOT
+            // HAS BEEN EMITTED ALREADY.
+            bool is_duplicated(false);
+            for (size_t j = 0; j < i_pt and not is_duplicated; ++j)
+                is_duplicated = (nodes[slots_pivot.at(j)] == m_pivot);
+
+            if (not is_duplicated)
+                m_targets.push_back(nodes);
+            ++iters[k];
+        }
+    }
 
     if (not m_targets.empty())
         kb::kb()->search_axioms_with_arity_pattern(*m_pt_iter, &m_axioms);
@@ -363,67 +648,70 @@ void proof_graph_t::loop_detector_t::construct()
 
 
 void proof_graph_t::unifiable_variable_clusters_set_t::add(
-    term_t t1, term_t t2 )
+    term_t t1, term_t t2, std::list< std::pair<term_t, term_t> > *out)
 {
-    m_variables.insert(t1);
-    m_variables.insert(t2);
-    
-    hash_map<term_t, index_t>::iterator iter_c1 = m_map_v2c.find(t1);
-    hash_map<term_t, index_t>::iterator iter_c2 = m_map_v2c.find(t2);
-    bool has_found_t1(iter_c1 != m_map_v2c.end());
-    bool has_found_t2(iter_c2 != m_map_v2c.end());
-    
-    if (not has_found_t1  and not has_found_t2)
-    {
-        m_idx_new_cluster++;
-        m_clusters[m_idx_new_cluster].insert(t1);
-        m_clusters[m_idx_new_cluster].insert(t2);
-        m_map_v2c[t1] = m_idx_new_cluster;
-        m_map_v2c[t2] = m_idx_new_cluster;
-    }
-    else if (has_found_t1 and has_found_t2)
-    {
-        // MERGE CLUSTERS OF t1 AND t2
-        if (iter_c1->second != iter_c2->second)
-        {
-            hash_set<term_t>& c1 = m_clusters[iter_c1->second];
-            hash_set<term_t>& c2 = m_clusters[iter_c2->second];
+    index_t r1 = find_root(get_index(t1));
+    index_t r2 = find_root(get_index(t2));
 
-            for (auto it = c2.begin(); it != c2.end(); ++it)
-                m_map_v2c[*it] = iter_c1->second;
+    // TERMS IN THE SAME CLUSTER HAVE BEEN CONNECTED ALREADY.
+    if (r1 == r2) return;
 
-            c1.insert(c2.begin(), c2.end());
-            c2.clear();
-        }
-    }
-    else if (has_found_t1 and not has_found_t2)
-    {
-        m_clusters[iter_c1->second].insert(t2);
-        m_map_v2c[t2] = iter_c1->second;
-    }
-    else if (not has_found_t1 and has_found_t2)
+    // UNION BY SIZE: MEMBERS OF THE SMALLER CLUSTER ARE MOVED.
+    if (m_members[r1].size() < m_members[r2].size())
+        std::swap(r1, r2);
+
+    std::vector<term_t> &c1 = m_members[r1];
+    std::vector<term_t> &c2 = m_members[r2];
+
+    // EVERY PAIR ACROSS THE TWO CLUSTERS IS CONNECTED NEWLY,
+    // SO THAT THE RESULT DOES NOT DEPEND ON THE ORDER OF ADDITIONS.
+    if (out != NULL)
     {
-        m_clusters[iter_c2->second].insert(t1);
-        m_map_v2c[t1] = iter_c2->second;
+        for (auto a : c1)
+        for (auto b : c2)
+            out->push_back(std::make_pair(a, b));
     }
+
+    c1.insert(c1.end(), c2.begin(), c2.end());
+    std::vector<term_t>().swap(c2);
+    m_parents[r2] = r1;
 }
 
 
 void proof_graph_t::unifiable_variable_clusters_set_t::merge(
     const unifiable_variable_clusters_set_t &vc)
 {
-    int padding(0);
-    for (auto it = m_clusters.begin(); it != m_clusters.end(); ++it)
-        padding = (padding > it->first) ? it->first : padding;
+    for (const auto &members : vc.m_members)
+    for (size_t i = 1; i < members.size(); ++i)
+        add(members.front(), members.at(i));
+}
+
 
-    m_variables.insert(vc.m_variables.begin(), vc.m_variables.end());
+std::list< const std::vector<term_t>* >
+proof_graph_t::unifiable_variable_clusters_set_t::clusters() const
+{
+    std::list< const std::vector<term_t>* > out;
 
-    for (auto it = vc.m_clusters.begin(); it != vc.m_clusters.end(); ++it)
-        m_clusters[it->first + padding].insert(
-        it->second.begin(), it->second.end());
+    for (index_t i = 0; i < static_cast<index_t>(m_parents.size()); ++i)
+    if (m_parents[i] == i)
+        out.push_back(&m_members[i]);
 
-    for (auto it = vc.m_map_v2c.begin(); it != vc.m_map_v2c.end(); ++it)
-        m_map_v2c[it->first] = (it->second + padding);
+    return out;
+}
+
+
+index_t proof_graph_t::unifiable_variable_clusters_set_t::get_index(term_t t)
+{
+    auto found = m_term2idx.find(t);
+    if (found != m_term2idx.end())
+        return found->second;
+
+    index_t idx = static_cast<index_t>(m_parents.size());
+    m_term2idx[t] = idx;
+    m_parents.push_back(idx);
+    m_members.push_back(std::vector<term_t>(1, t));
+
+    return idx;
 }
 
 
@@ -432,6 +720,7 @@ void proof_graph_t::temporal_variables_t::clear()
     postponed_unifications.clear();
     considered_unifications.clear();
     coexistability_logs.clear();
+    soft_unifiable_predicates.clear();
     argument_set_ids.clear();
 }
 
@@ -441,20 +730,18 @@ proof_graph_t::proof_graph_t(phillip_main_t *main, const std::string &name)
 {
     m_threshold_distance_for_soft_unify =
         m_phillip->param_float("threshold_soft_unify", kb::kb()->get_max_distance());
+
+    int num_thread = std::min<int>(
+        m_phillip->param_int("lhs_thread_num", 1), std::thread::hardware_concurrency());
+    if (num_thread > 1)
+        m_thread_pool.reset(new util::thread_pool_t(num_thread));
 }
 
 
-std::list< const hash_set<term_t>* >
+std::list< const std::vector<term_t>* >
     proof_graph_t::enumerate_variable_clusters() const
 {
-    std::list< const hash_set<term_t>* > out;
-    const hash_map<index_t, hash_set<term_t> >
-        &clusters = m_vc_unifiable.clusters();
-
-    for (auto it = clusters.begin(); it != clusters.end(); ++it)
-        out.push_back(&it->second);
-
-    return out;
+    return m_vc_unifiable.clusters();
 }
 
 
@@ -469,38 +756,37 @@ hash_set<edge_idx_t> proof_graph_t::enumerate_dependent_edges(node_idx_t idx) co
 void proof_graph_t::enumerate_dependent_edges(
     node_idx_t idx, hash_set<edge_idx_t> *out) const
 {
-    if (not node(idx).literal().is_equality())
-    {
-        hypernode_idx_t m = node(idx).master_hypernode();
-        if (m < 0) return;
-
-        edge_idx_t e = find_parental_edge(m);
-        out->insert(e);
-
-        auto _nodes = hypernode(edge(e).tail());
-        for (auto it = _nodes.begin(); it != _nodes.end(); ++it)
-            enumerate_dependent_edges(*it, out);
-    }
+    const node_set_t &es = dependent_edges(idx);
+    out->insert(es.begin(), es.end());
 }
 
 
 void proof_graph_t::enumerate_dependent_nodes(
     node_idx_t idx, hash_set<node_idx_t> *out) const
 {
-    if (not node(idx).literal().is_equality())
-    {
-        hypernode_idx_t m = node(idx).master_hypernode();
-        if (m < 0) return;
+    const node_set_t &ns = dependent_nodes(idx);
+    out->insert(ns.begin(), ns.end());
+}
 
-        edge_idx_t e = find_parental_edge(m);
-        auto _nodes = hypernode(edge(e).tail());
 
-        for (auto it = _nodes.begin(); it != _nodes.end(); ++it)
-        {
-            out->insert(*it);
-            enumerate_dependent_nodes(*it, out);
-        }
+void proof_graph_t::_update_dependencies(edge_idx_t idx)
+{
+    const edge_t &e = edge(idx);
+    const std::vector<node_idx_t> &tail = hypernode(e.tail());
+    dependency_t dep;
+
+    dep.edges.insert(idx);
+    dep.nodes.insert(tail.begin(), tail.end());
+
+    for (auto n : tail)
+    {
+        dep.edges.insert(m_dependencies.at(n).edges);
+        dep.nodes.insert(m_dependencies.at(n).nodes);
     }
+
+    for (auto n : hypernode(e.head()))
+    if (not node(n).literal().is_equality())
+        m_dependencies.at(n) = dep;
 }
 
 
@@ -548,22 +834,16 @@ bool proof_graph_t::_check_nodes_coexistability(
         if (log != NULL) return (*log);
     }
     
-    hash_set<edge_idx_t>
-        e1(enumerate_dependent_edges(n1)),
-        e2(enumerate_dependent_edges(n2));
-    if (e1.size() > e2.size()) std::swap(e1, e2);
+    const node_set_t *e1(&dependent_edges(n1)), *e2(&dependent_edges(n2));
+    if (e1->size() > e2->size()) std::swap(e1, e2);
 
-    for (auto it = e1.begin(); it != e1.end(); ++it)
+    // A EDGE SHARED BY e1 AND e2 IS SKIPPED.
+    for (auto e : e1->difference(*e2))
     {
-        // A EDGE SHARED BY e1 AND e2 IS SKIPPED.
-        if (e2.count(*it) > 0) continue;
-
-        auto found = m_mutual_exclusive_edges.find(*it);
+        auto found = m_mutual_exclusive_edges.find(e);
         if (found == m_mutual_exclusive_edges.end()) continue;
 
-        auto muex_edges = found->second;
-        if (util::has_intersection<hash_set<edge_idx_t>::const_iterator>(
-            muex_edges.begin(), muex_edges.end(), e2.begin(), e2.end()))
+        if (found->second.has_intersection(*e2))
         {
             if (uni == NULL)
                 m_temporal.coexistability_logs.insert(n1, n2, false);
@@ -571,11 +851,8 @@ bool proof_graph_t::_check_nodes_coexistability(
         }
     }
 
-    hash_set<node_idx_t> ns1, ns2;
+    node_set_t ns1(dependent_nodes(n1)), ns2(dependent_nodes(n2));
     {
-        enumerate_dependent_nodes(n1, &ns1);
-        enumerate_dependent_nodes(n2, &ns2);
-        
         auto hn1 = hypernode(node(n1).master_hypernode());
         auto hn2 = hypernode(node(n2).master_hypernode());
         ns1.insert(hn1.begin(), hn1.end());
@@ -584,15 +861,13 @@ bool proof_graph_t::_check_nodes_coexistability(
     
     if (ns1.size() > ns2.size()) std::swap(ns1, ns2);
 
-    for (auto it = ns1.begin(); it != ns1.end(); ++it)
+    // NODES SHARED BY BOTH OF ns1 and ns2 ARE SKIPPED.
+    for (auto n : ns1.difference(ns2))
     {
-        // SHARED BY BOTH OF ns1 and ns2, IT WILL BE SKIPPED.
-        if (ns2.count(*it) > 0) continue;
-
-        for (auto it2 = ns2.begin(); it2 != ns2.end(); ++it2)
+        // ONLY NODES MUTUAL-EXCLUSIVE WITH n ARE CHECKED.
+        for (auto m : m_mutual_exclusive_node_sets.at(n).intersection(ns2))
         {
-            const unifier_t *uni2 =
-                search_mutual_exclusion_of_node(*it, *it2);
+            const unifier_t *uni2 = search_mutual_exclusion_of_node(n, m);
 
             if (uni2 != NULL)
             {
@@ -691,19 +966,60 @@ const arity_t &arity, hash_set<node_idx_t> *out) const
         out->insert(ns1->begin(), ns1->end());
 
     if (kb::kb()->category_table()->do_target(arity))
+        _enumerate_nodes_softly_unifiable(kb::kb()->search_arity_id(arity), out);
+}
+
+
+void proof_graph_t::enumerate_nodes_softly_unifiable(
+const literal_t &lit, hash_set<node_idx_t> *out) const
+{
+    // THE ARITY OF A NEGATED LITERAL, SUCH AS "!p/1", MATCHES NO PREDICATE,
+    // SO THAT NO NODE IS FOUND HERE AS WELL AS THE VERSION ABOVE.
+    if (lit.truth)
+    {
+        const hash_set<node_idx_t> *ns1 =
+            search_nodes_with_predicate(lit.predicate, lit.terms.size());
+        if (ns1 != NULL)
+            out->insert(ns1->begin(), ns1->end());
+    }
+
+    if (kb::kb()->category_table()->do_target(lit.get_arity()))
+        _enumerate_nodes_softly_unifiable(kb::kb()->search_arity_id(lit), out);
+}
+
+
+void proof_graph_t::_enumerate_nodes_softly_unifiable(
+kb::arity_id_t id, hash_set<node_idx_t> *out) const
+{
+    if (id == kb::INVALID_ARITY_ID) return;
+
+    auto found = m_temporal.soft_unifiable_predicates.find(id);
+
+    if (found == m_temporal.soft_unifiable_predicates.end())
     {
-        for (auto p1 : m_maps.predicate_to_nodes)
-        for (auto p2 : p1.second)
-        if (p2.first == 1)
+        std::vector<kb::arity_id_t> neighbors;
+        std::vector<predicate_t> &preds = m_temporal.soft_unifiable_predicates[id];
+
+        kb::kb()->category_table()->get_neighbors(
+            id, threshold_distance_for_soft_unifying(), &neighbors);
+
+        for (auto a : neighbors)
         {
-            arity_t arity2 = literal_t::get_arity(p1.first, p2.first, false);
-            if (arity2 != arity)
-            {
-                float dist = kb::kb()->category_table()->get(arity, arity2);
-                if (dist >= 0.0 and dist < threshold_distance_for_soft_unifying())
-                    out->insert(p2.second.begin(), p2.second.end());
-            }
+            predicate_t pred;
+            int num;
+            if (util::parse_arity(kb::kb()->search_arity(a), &pred, &num))
+            if (num == 1 and pred.at(0) != '!')
+                preds.push_back(pred);
         }
+
+        found = m_temporal.soft_unifiable_predicates.find(id);
+    }
+
+    for (const auto &pred : found->second)
+    {
+        const hash_set<node_idx_t> *ns2 = search_nodes_with_predicate(pred, 1);
+        if (ns2 != NULL)
+            out->insert(ns2->begin(), ns2->end());
     }
 }
 
@@ -745,7 +1061,7 @@ hash_set<edge_idx_t> proof_graph_t::enumerate_edges_with_node(node_idx_t idx) co
 
 edge_idx_t proof_graph_t::find_parental_edge(hypernode_idx_t idx) const
 {
-    const hash_set<edge_idx_t> *_edges = search_edges_with_hypernode(idx);
+    const std::vector<edge_idx_t> *_edges = search_edges_with_hypernode(idx);
 
     if (_edges != NULL)
     {
@@ -762,7 +1078,7 @@ edge_idx_t proof_graph_t::find_parental_edge(hypernode_idx_t idx) const
 
 void proof_graph_t::enumerate_parental_edges(hypernode_idx_t idx, hash_set<edge_idx_t> *out) const
 {
-    const hash_set<edge_idx_t> *_edges = search_edges_with_hypernode(idx);
+    const std::vector<edge_idx_t> *_edges = search_edges_with_hypernode(idx);
     if( _edges == NULL ) return;
 
     for (auto it = _edges->begin(); it != _edges->end(); ++it)
@@ -776,7 +1092,7 @@ void proof_graph_t::enumerate_parental_edges(hypernode_idx_t idx, hash_set<edge_
 void proof_graph_t::enumerate_children_edges(
     hypernode_idx_t idx, hash_set<edge_idx_t> *out) const
 {
-    const hash_set<edge_idx_t> *_edges = search_edges_with_hypernode(idx);
+    const std::vector<edge_idx_t> *_edges = search_edges_with_hypernode(idx);
     if( _edges == NULL ) return;
 
     for (auto it = _edges->begin(); it != _edges->end(); ++it)
@@ -790,7 +1106,7 @@ void proof_graph_t::enumerate_children_edges(
 void proof_graph_t::enumerate_children_hypernodes(
     hypernode_idx_t idx, hash_set<hypernode_idx_t> *out) const
 {
-    const hash_set<edge_idx_t> *_edges = search_edges_with_hypernode(idx);
+    const std::vector<edge_idx_t> *_edges = search_edges_with_hypernode(idx);
     if (_edges == NULL) return;
 
     for (auto it = _edges->begin(); it != _edges->end(); ++it)
@@ -810,7 +1126,7 @@ void proof_graph_t::enumerate_descendant_nodes(
 
     f = [this, &f](node_idx_t idx, hash_set<node_idx_t> *out, hash_set<hypernode_idx_t> *checked)
     {
-        const hash_set<hypernode_idx_t> *hns = this->search_hypernodes_with_node(idx);
+        const std::vector<hypernode_idx_t> *hns = this->search_hypernodes_with_node(idx);
 
         if (hns != NULL)
         for (auto hn = hns->begin(); hn != hns->end(); ++hn)
@@ -838,7 +1154,7 @@ void proof_graph_t::enumerate_descendant_nodes(
 void proof_graph_t::enumerate_parental_hypernodes(
     hypernode_idx_t idx, hash_set<hypernode_idx_t> *out) const
 {
-    const hash_set<edge_idx_t> *_edges = search_edges_with_hypernode(idx);
+    const std::vector<edge_idx_t> *_edges = search_edges_with_hypernode(idx);
     if (_edges == NULL) return;
 
     for (auto it = _edges->begin(); it != _edges->end(); ++it)
@@ -867,7 +1183,7 @@ void proof_graph_t::enumerate_overlapping_hypernodes(
 hypernode_idx_t proof_graph_t::find_hypernode_with_ordered_nodes(
     const std::vector<node_idx_t> &indices ) const
 {
-    const hash_set<hypernode_idx_t> *hypernodes
+    const std::vector<hypernode_idx_t> *hypernodes
         = search_hypernodes_with_node(indices.at(0));
     if (hypernodes != NULL)
     {
@@ -921,7 +1237,7 @@ edge_idx_t proof_graph_t::find_unifying_edge(node_idx_t i, node_idx_t j) const
         if (hn < 0) return -1;
     }
 
-    const hash_set<edge_idx_t> *es = search_edges_with_hypernode(hn);
+    const std::vector<edge_idx_t> *es = search_edges_with_hypernode(hn);
     for (auto it = es->begin(); it != es->end(); ++it)
     {
         const edge_t &e = edge(*it);
@@ -934,7 +1250,7 @@ edge_idx_t proof_graph_t::find_unifying_edge(node_idx_t i, node_idx_t j) const
 
 
 bool proof_graph_t::axiom_has_applied(
-    hypernode_idx_t hn, const lf::axiom_t &ax, bool is_backward ) const
+    hypernode_idx_t hn, const lf::axiom_view_t &ax, bool is_backward ) const
 {
     const hash_map< axiom_id_t, hash_set<hypernode_idx_t> >
         &map = is_backward ?
@@ -1091,12 +1407,13 @@ void proof_graph_t::print_edges(std::ostream *os) const
 void proof_graph_t::print_subs(std::ostream *os) const
 {
     auto subs = m_vc_unifiable.clusters();
+    int id(0);
     (*os) << "<substitutions>" << std::endl;
 
     for (auto it = subs.begin(); it != subs.end(); ++it)
     {
-        (*os) << "<cluster id=\"" << it->first << "\">" << std::endl;
-        for (auto t = it->second.begin(); t != it->second.end(); ++t)
+        (*os) << "<cluster id=\"" << (++id) << "\">" << std::endl;
+        for (auto t = (*it)->begin(); t != (*it)->end(); ++t)
             (*os) << "<term>" << t->string() << "</term>" << std::endl;
         (*os) << "</cluster>" << std::endl;
     }
@@ -1107,26 +1424,21 @@ void proof_graph_t::print_subs(std::ostream *os) const
 
 void proof_graph_t::print_mutual_exclusive_nodes(std::ostream *os) const
 {
-    const hash_map<node_idx_t, hash_map<node_idx_t, unifier_t> >
+    const util::triangular_matrix_t<node_idx_t, unifier_t>
         &muexs = m_mutual_exclusive_nodes;
-    int num(0);
-
-    for (auto it = muexs.begin(); it != muexs.end(); ++it)
-        num += it->second.size();
 
     (*os) << "<mutual_exclusive_nodes num=\""
-          << num << "\">" << std::endl;
+          << muexs.size() << "\">" << std::endl;
 
-    for (auto it1 = muexs.begin(); it1 != muexs.end(); ++it1)
-    for (auto it2 = it1->second.begin(); it2 != it1->second.end(); ++it2)
+    for (auto it = muexs.begin(); it != muexs.end(); ++it)
     {
-        const node_t &n1 = node(it1->first);
-        const node_t &n2 = node(it2->first);
+        const node_t &n1 = node(it->first());
+        const node_t &n2 = node(it->second());
 
         (*os)
             << "<xor node1=\"" << n1.index()
             << "\" node2=\"" << n2.index()
-            << "\" subs=\"" << it2->second.to_string() << "\">"
+            << "\" subs=\"" << it->value.to_string() << "\">"
             << n1.literal().to_string() << " _|_ "
             << n2.literal().to_string() << "</xor>" << std::endl;
     }
@@ -1137,8 +1449,7 @@ void proof_graph_t::print_mutual_exclusive_nodes(std::ostream *os) const
 
 void proof_graph_t::print_mutual_exclusive_edges(std::ostream *os) const
 {
-    const hash_map<edge_idx_t, hash_set<edge_idx_t> >
-        &muexs = m_mutual_exclusive_edges;
+    const hash_map<edge_idx_t, node_set_t> &muexs = m_mutual_exclusive_edges;
     int num(0);
 
     for (auto it = muexs.begin(); it != muexs.end(); ++it)
@@ -1155,27 +1466,516 @@ void proof_graph_t::print_mutual_exclusive_edges(std::ostream *os) const
 }
 
 
+/** The magic number at the beginning of each record of proof-graphs. */
+static const uint32_t PROOF_GRAPH_BINARY_MAGIC = 0x32475250; // "PRG2"
+
+
+/** A file of proof-graph records and the ranges of records indexed by names. */
+struct proof_graph_binary_file_t
+{
+    util::mapped_file_t file;
+    hash_map<std::string, std::pair<size_t, size_t> > records;
+};
+
+
+/** Returns the file of given name, which is opened and indexed only once,
+ *  so that loading each proof-graph does not scan the whole file.
+ *  The file must not be modified while the process is running. */
+static const proof_graph_binary_file_t& open_proof_graph_binary(const std::string &filename)
+{
+    static std::mutex mutex;
+    static hash_map<std::string, std::unique_ptr<proof_graph_binary_file_t> > files;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = files.find(filename);
+    if (found != files.end())
+        return *found->second;
+
+    std::unique_ptr<proof_graph_binary_file_t> out(new proof_graph_binary_file_t());
+    if (not out->file.open(filename))
+        throw phillip_exception_t("Failed to open a binary file: " + filename);
+
+    const char *data = out->file.data();
+    util::binary_reader_t rd(data, data + out->file.size());
+
+    while (not rd.eof())
+    {
+        uint32_t magic;
+        std::string name;
+
+        rd.read(&magic);
+        if (magic != PROOF_GRAPH_BINARY_MAGIC)
+            throw phillip_exception_t("Invalid binary of proof-graphs: " + filename);
+
+        rd.read_string(&name);
+        size_t size = static_cast<size_t>(rd.read_varint());
+
+        // skip THROWS AN EXCEPTION IF THE RECORD HAS BEEN TRUNCATED.
+        size_t begin = static_cast<size_t>(rd.ptr() - data);
+        rd.skip(size);
+
+        // THE FIRST RECORD OF EACH NAME IS USED.
+        out->records.insert(std::make_pair(name, std::make_pair(begin, begin + size)));
+    }
+
+    return *(files[filename] = std::move(out));
+}
+
+
+void proof_graph_t::write_binary(std::ostream *os) const
+{
+    util::binary_writer_t wr;
+    hash_map<term_t, size_t> term2id;
+    std::vector<term_t> terms;
+
+    // TERMS AND PREDICATES ARE WRITTEN AS IDS IN THE TABLE OF STRINGS,
+    // BECAUSE THEIR HASHES DEPEND ON THE ORDER OF INTERNING.
+    auto write_term = [&](const term_t &t)
+    {
+        auto found = term2id.find(t);
+        if (found == term2id.end())
+        {
+            found = term2id.insert(std::make_pair(t, terms.size())).first;
+            terms.push_back(t);
+        }
+        wr.write_varint(found->second);
+    };
+    auto write_literal = [&](const literal_t &lit)
+    {
+        write_term(lit.predicate);
+        wr.write_varint(lit.terms.size());
+        for (const auto &t : lit.terms) write_term(t);
+        wr.write<char>(lit.truth ? 1 : 0);
+    };
+    auto write_indices = [&](const hash_set<index_t> &indices)
+    {
+        wr.write_varint(indices.size());
+        for (auto i : indices) wr.write_varint(i);
+    };
+    auto write_term_pairs = [&](
+        const hash_map<edge_idx_t, std::list< std::pair<term_t, term_t> > > &conds)
+    {
+        wr.write_varint(conds.size());
+        for (const auto &p : conds)
+        {
+            wr.write_varint(p.first);
+            wr.write_varint(p.second.size());
+            for (const auto &ts : p.second)
+            {
+                write_term(ts.first);
+                write_term(ts.second);
+            }
+        }
+    };
+
+    wr.write<char>(m_is_timeout ? 1 : 0);
+    wr.write(m_threshold_distance_for_soft_unify);
+
+    wr.write_varint(m_attributes.size());
+    for (const auto &p : m_attributes)
+    {
+        wr.write_string(p.first);
+        wr.write_string(p.second);
+    }
+
+    // NODES
+    wr.write_varint(m_nodes.size());
+    for (const auto &n : m_nodes)
+    {
+        wr.write_varint(n.m_type);
+        write_literal(n.m_literal);
+        wr.write_varint(n.m_master_hypernode_idx + 1);
+        wr.write_varint(n.m_depth + 1);
+        wr.write(n.m_arity_id);
+        write_indices(n.m_parents);
+        n.m_ancestors.write_binary(&wr);
+        n.m_relatives.write_binary(&wr);
+    }
+
+    // HYPERNODES & EDGES
+    wr.write_varint(m_hypernodes.size());
+    for (const auto &hn : m_hypernodes)
+        wr.write_array(hn);
+
+    wr.write_varint(m_edges.size());
+    for (const auto &e : m_edges)
+    {
+        wr.write_varint(e.type());
+        wr.write_varint(e.tail());
+        wr.write_varint(e.head() + 1);
+        wr.write_varint(e.axiom_id() + 1);
+    }
+
+    write_indices(m_observations);
+
+    wr.write_varint(m_requirements.size());
+    for (const auto &req : m_requirements)
+    {
+        wr.write<char>(req.is_gold ? 1 : 0);
+        wr.write_varint(req.conjunction.size());
+        for (const auto &e : req.conjunction)
+        {
+            write_literal(e.literal);
+            wr.write_varint(e.index + 1);
+        }
+    }
+
+    // MUTUAL EXCLUSIONS
+    wr.write_varint(m_mutual_exclusive_nodes.size());
+    for (const auto &e : m_mutual_exclusive_nodes)
+    {
+        wr.write_varint(e.first());
+        wr.write_varint(e.second());
+        wr.write_varint(e.value.substitutions().size());
+        for (const auto &sub : e.value.substitutions())
+        {
+            write_term(sub.terms.at(0));
+            write_term(sub.terms.at(1));
+        }
+    }
+
+    for (const auto &ns : m_mutual_exclusive_node_sets)
+        ns.write_binary(&wr);
+
+    wr.write_varint(m_mutual_exclusive_edges.size());
+    for (const auto &p : m_mutual_exclusive_edges)
+    {
+        wr.write_varint(p.first);
+        p.second.write_binary(&wr);
+    }
+
+    // DEPENDENCIES
+    for (const auto &dep : m_dependencies)
+    {
+        dep.edges.write_binary(&wr);
+        dep.nodes.write_binary(&wr);
+    }
+
+    // VARIABLE CLUSTERS
+    {
+        const unifiable_variable_clusters_set_t &vc = m_vc_unifiable;
+        std::vector<term_t> idx2term(vc.m_parents.size());
+        for (const auto &p : vc.m_term2idx)
+            idx2term[p.second] = p.first;
+
+        wr.write_varint(idx2term.size());
+        for (const auto &t : idx2term) write_term(t);
+        for (const auto &i : vc.m_parents) wr.write_varint(i);
+
+        // MEMBERS ARE WRITTEN IN THEIR ORDER, WHICH DEPENDS ON THE ORDER OF MERGING.
+        for (const auto &ms : vc.m_members)
+        {
+            wr.write_varint(ms.size());
+            for (const auto &t : ms) write_term(t);
+        }
+    }
+
+    write_indices(m_indices_of_unification_hypernodes);
+    write_term_pairs(m_subs_of_conditions_for_chain);
+    write_term_pairs(m_neqs_of_conditions_for_chain);
+
+    for (auto ax2hn : { &m_maps.axiom_to_hypernodes_forward, &m_maps.axiom_to_hypernodes_backward })
+    {
+        wr.write_varint(ax2hn->size());
+        for (const auto &p : (*ax2hn))
+        {
+            wr.write_varint(p.first);
+            write_indices(p.second);
+        }
+    }
+
+    // THE TABLE OF STRINGS PRECEDES THE BODY.
+    util::binary_writer_t head;
+    head.write_varint(terms.size());
+    for (const auto &t : terms)
+        head.write_string(t.string());
+
+    util::binary_writer_t record;
+    record.write(PROOF_GRAPH_BINARY_MAGIC);
+    record.write_string(name());
+    record.write_varint(head.size() + wr.size());
+
+    os->write(record.data(), record.size());
+    os->write(head.data(), head.size());
+    os->write(wr.data(), wr.size());
+}
+
+
+bool proof_graph_t::read_binary(const std::string &filename)
+{
+    assert(m_nodes.empty());
+
+    const proof_graph_binary_file_t &bin = open_proof_graph_binary(filename);
+    auto found = bin.records.find(m_name);
+
+    if (found == bin.records.end()) return false;
+
+    const char *begin = bin.file.data() + found->second.first;
+    const char *end = bin.file.data() + found->second.second;
+    util::binary_reader_t rd(begin, end);
+
+    // EVERY INDEX READ IS CHECKED, SO THAT A BROKEN BINARY CANNOT BREAK MEMORY.
+    auto throw_invalid = [&]()
+    {
+        throw phillip_exception_t("Invalid binary of proof-graphs: " + filename);
+    };
+    auto read_index = [&](size_t limit) -> index_t
+    {
+        size_t idx = static_cast<size_t>(rd.read_varint());
+        if (idx >= limit) throw_invalid();
+        return static_cast<index_t>(idx);
+    };
+
+    // EACH ELEMENT TAKES ONE BYTE AT LEAST,
+    // SO A COUNT LARGER THAN THE REST OF THE RECORD IS BROKEN.
+    auto read_count = [&]() -> size_t
+    {
+        return static_cast<size_t>(read_index(static_cast<size_t>(end - rd.ptr()) + 1));
+    };
+
+    std::vector<term_t> terms(read_count());
+
+    for (auto &t : terms)
+    {
+        std::string str;
+        rd.read_string(&str);
+        t = term_t(str);
+    }
+
+    auto read_node_set = [&](node_set_t *out, size_t limit)
+    {
+        if (not out->read_binary(&rd, static_cast<index_t>(limit)))
+            throw_invalid();
+    };
+    auto read_term = [&]() -> const term_t&
+    {
+        return terms[read_index(terms.size())];
+    };
+    auto read_literal = [&](literal_t *out)
+    {
+        const term_t &pred = read_term();
+        size_t n = static_cast<size_t>(rd.read_varint());
+        std::vector<term_t> ts;
+
+        for (size_t i = 0; i < n; ++i)
+            ts.push_back(read_term());
+
+        char truth;
+        rd.read(&truth);
+
+        // EQUALITIES ARE REGULARIZED AGAIN, BECAUSE THE ORDER OF TERMS
+        // DEPENDS ON THEIR HASHES.
+        if (pred == "=")
+        {
+            if (n != 2) throw_invalid();
+            (*out) = literal_t("=", ts.at(0), ts.at(1), truth != 0);
+        }
+        else
+            (*out) = literal_t(pred, ts, truth != 0);
+    };
+    auto read_indices = [&](hash_set<index_t> *out, size_t limit)
+    {
+        size_t n = read_count();
+        out->reserve(n);
+        for (size_t i = 0; i < n; ++i)
+            out->insert(read_index(limit));
+    };
+    auto read_term_pairs = [&](
+        hash_map<edge_idx_t, std::list< std::pair<term_t, term_t> > > *out)
+    {
+        size_t n = static_cast<size_t>(rd.read_varint());
+        for (size_t i = 0; i < n; ++i)
+        {
+            std::list< std::pair<term_t, term_t> > &ts = (*out)[read_index(m_edges.size())];
+            size_t m = static_cast<size_t>(rd.read_varint());
+            for (size_t j = 0; j < m; ++j)
+            {
+                term_t t1 = read_term();
+                ts.push_back(std::make_pair(t1, read_term()));
+            }
+        }
+    };
+
+    char flag;
+    rd.read(&flag);
+    m_is_timeout = (flag != 0);
+    rd.read(&m_threshold_distance_for_soft_unify);
+
+    for (size_t i = rd.read_varint(); i > 0; --i)
+    {
+        std::string key, value;
+        rd.read_string(&key);
+        rd.read_string(&value);
+        m_attributes[key] = value;
+    }
+
+    // NODES
+    // MASTER HYPERNODES ARE CHECKED AFTER HYPERNODES ARE READ.
+    size_t num_nodes = read_count();
+    m_nodes.reserve(num_nodes);
+    for (size_t i = 0; i < num_nodes; ++i)
+    {
+        node_t n;
+        n.m_type = static_cast<node_type_e>(read_index(NODE_REQUIRED + 1));
+        read_literal(&n.m_literal);
+        n.m_index = i;
+        n.m_master_hypernode_idx = static_cast<hypernode_idx_t>(rd.read_varint()) - 1;
+        n.m_depth = static_cast<depth_t>(read_index(INT_MAX)) - 1;
+        rd.read(&n.m_arity_id);
+        if (n.m_arity_id >= kb::kb()->num_arities()) throw_invalid();
+        read_indices(&n.m_parents, num_nodes);
+        read_node_set(&n.m_ancestors, num_nodes);
+        read_node_set(&n.m_relatives, num_nodes);
+        m_nodes.push_back(n);
+    }
+
+    // HYPERNODES & EDGES
+    m_hypernodes.resize(read_count());
+    for (auto &hn : m_hypernodes)
+    {
+        rd.read_array(&hn);
+        for (auto n : hn)
+        if (n < 0 or n >= static_cast<node_idx_t>(num_nodes))
+            throw_invalid();
+    }
+
+    for (const auto &n : m_nodes)
+    if (n.m_master_hypernode_idx < -1 or
+        n.m_master_hypernode_idx >= static_cast<hypernode_idx_t>(m_hypernodes.size()))
+        throw_invalid();
+
+    size_t num_edges = read_count();
+    m_edges.reserve(num_edges);
+    for (size_t i = 0; i < num_edges; ++i)
+    {
+        edge_type_e type = static_cast<edge_type_e>(rd.read_varint());
+        hypernode_idx_t tail = read_index(m_hypernodes.size());
+        hypernode_idx_t head = read_index(m_hypernodes.size() + 1) - 1;
+        axiom_id_t id = static_cast<axiom_id_t>(rd.read_varint()) - 1;
+        m_edges.push_back(edge_t(type, tail, head, id));
+    }
+
+    read_indices(&m_observations, num_nodes);
+
+    m_requirements.resize(read_count());
+    for (auto &req : m_requirements)
+    {
+        rd.read(&flag);
+        req.is_gold = (flag != 0);
+        for (size_t i = rd.read_varint(); i > 0; --i)
+        {
+            requirement_t::element_t e;
+            read_literal(&e.literal);
+            e.index = read_index(num_nodes + 1) - 1;
+            req.conjunction.push_back(e);
+        }
+    }
+
+    // MUTUAL EXCLUSIONS
+    for (size_t i = rd.read_varint(); i > 0; --i)
+    {
+        node_idx_t n1 = read_index(num_nodes);
+        node_idx_t n2 = read_index(num_nodes);
+        unifier_t uni;
+
+        for (size_t j = rd.read_varint(); j > 0; --j)
+        {
+            term_t t1 = read_term();
+            uni.add(t1, read_term());
+        }
+        m_mutual_exclusive_nodes.assign(n1, n2, uni);
+    }
+
+    m_mutual_exclusive_node_sets.resize(m_nodes.size());
+    for (auto &ns : m_mutual_exclusive_node_sets)
+        read_node_set(&ns, num_nodes);
+
+    for (size_t i = rd.read_varint(); i > 0; --i)
+    {
+        edge_idx_t e = read_index(num_edges);
+        read_node_set(&m_mutual_exclusive_edges[e], num_edges);
+    }
+
+    // DEPENDENCIES
+    m_dependencies.resize(m_nodes.size());
+    for (auto &dep : m_dependencies)
+    {
+        read_node_set(&dep.edges, num_edges);
+        read_node_set(&dep.nodes, num_nodes);
+    }
+
+    // VARIABLE CLUSTERS
+    {
+        unifiable_variable_clusters_set_t &vc = m_vc_unifiable;
+        size_t n = read_count();
+        for (size_t i = 0; i < n; ++i)
+            vc.m_term2idx[read_term()] = i;
+
+        vc.m_parents.resize(n);
+        vc.m_members.resize(n);
+        for (auto &p : vc.m_parents)
+            p = read_index(n);
+
+        // EVERY CHAIN OF PARENTS MUST REACH A ROOT, OTHERWISE find_root LOOPS FOREVER.
+        // 0: NOT VISITED, 1: ON THE CURRENT CHAIN, 2: REACHES A ROOT.
+        std::vector<char> states(n, 0);
+        std::vector<index_t> chain;
+        for (size_t i = 0; i < n; ++i)
+        {
+            index_t j = static_cast<index_t>(i);
+            for (; states[j] == 0 and vc.m_parents[j] != j; j = vc.m_parents[j])
+            {
+                states[j] = 1;
+                chain.push_back(j);
+            }
+            if (states[j] == 1) throw_invalid();
+
+            states[j] = 2;
+            for (auto k : chain) states[k] = 2;
+            chain.clear();
+        }
+
+        for (auto &ms : vc.m_members)
+        for (size_t j = rd.read_varint(); j > 0; --j)
+            ms.push_back(read_term());
+    }
+
+    read_indices(&m_indices_of_unification_hypernodes, m_hypernodes.size());
+    read_term_pairs(&m_subs_of_conditions_for_chain);
+    read_term_pairs(&m_neqs_of_conditions_for_chain);
+
+    for (auto ax2hn : { &m_maps.axiom_to_hypernodes_forward, &m_maps.axiom_to_hypernodes_backward })
+    for (size_t i = rd.read_varint(); i > 0; --i)
+    {
+        axiom_id_t id = static_cast<axiom_id_t>(rd.read_varint());
+        read_indices(&(*ax2hn)[id], m_hypernodes.size());
+    }
+
+    // THE OTHER MAPS ARE RESTORED FROM NODES, HYPERNODES AND EDGES.
+    for (node_idx_t i = 0; i < static_cast<node_idx_t>(m_nodes.size()); ++i)
+        _index_node(i);
+    for (hypernode_idx_t i = 0; i < static_cast<hypernode_idx_t>(m_hypernodes.size()); ++i)
+        _index_hypernode(i);
+    for (edge_idx_t i = 0; i < static_cast<edge_idx_t>(m_edges.size()); ++i)
+        _index_edge(i);
+
+    return true;
+}
+
+
 node_idx_t proof_graph_t::add_node(
     const literal_t &lit, node_type_e type, int depth,
     const hash_set<node_idx_t> &parents)
 {
     node_t add(this, lit, type, m_nodes.size(), depth, parents);
-    int n = static_cast<int>(lit.terms.size());
     node_idx_t out = m_nodes.size();
     
     m_nodes.push_back(add);
-    m_maps.predicate_to_nodes[lit.predicate][n].insert(out);
-    m_maps.depth_to_nodes[depth].insert(out);
+    m_dependencies.push_back(dependency_t());
+    m_mutual_exclusive_node_sets.push_back(node_set_t());
+    _index_node(out);
     
-    if(lit.is_equality())
-    {
-        term_t t1(lit.terms[0]), t2(lit.terms[1]);
-        if (lit.truth)
-            m_maps.terms_to_sub_node.insert(t1, t2, out);
-        else
-            m_maps.terms_to_negsub_node.insert(t1, t2, out);
-    }
-    else
+    if (not lit.is_equality())
     {
         const kb::knowledge_base_t *base = kb::knowledge_base_t::instance();
         std::string arity = lit.get_arity();
@@ -1186,17 +1986,37 @@ node_idx_t proof_graph_t::add_node(
             if (id != kb::INVALID_ARGUMENT_SET_ID)
                 m_temporal.argument_set_ids[std::make_pair(out, i)] = id;
         }
-        if (add.arity_id() != kb::INVALID_ARITY_ID)
-            m_maps.arity_to_nodes[add.arity_id()].insert(out);
     }
+
+    return out;
+}
+
+
+void proof_graph_t::_index_node(node_idx_t idx)
+{
+    const node_t &add = node(idx);
+    const literal_t &lit = add.literal();
+    int n = static_cast<int>(lit.terms.size());
+
+    m_maps.predicate_to_nodes[lit.predicate][n].insert(idx);
+    m_maps.depth_to_nodes.add(add.depth() + 1, idx);
+    
+    if(lit.is_equality())
+    {
+        term_t t1(lit.terms[0]), t2(lit.terms[1]);
+        if (lit.truth)
+            m_maps.terms_to_sub_node.insert(t1, t2, idx);
+        else
+            m_maps.terms_to_negsub_node.insert(t1, t2, idx);
+    }
+    else if (add.arity_id() != kb::INVALID_ARITY_ID)
+        m_maps.arity_to_nodes[add.arity_id()].push_back(idx);
     
     for (unsigned i = 0; i < lit.terms.size(); i++)
     {
         const term_t& t = lit.terms.at(i);
-        m_maps.term_to_nodes[t].insert(out);
+        m_maps.term_to_nodes[t].insert(idx);
     }
-
-    return out;
 }
 
 
@@ -1204,23 +2024,35 @@ edge_idx_t proof_graph_t::add_edge(const edge_t &edge)
 {
     edge_idx_t idx = m_edges.size();
 
-    m_maps.hypernode_to_edge[edge.head()].insert(idx);
-    m_maps.hypernode_to_edge[edge.tail()].insert(idx);
-
-    if (edge.head() >= 0)
-    for (auto n_idx : hypernode(edge.head()))
-        m_maps.head_node_to_edges[n_idx].insert(idx);
-    
-    for (auto n_idx : hypernode(edge.tail()))
-        m_maps.tail_node_to_edges[n_idx].insert(idx);
-
     m_edges.push_back(edge);
+    _index_edge(idx);
+
     return idx;
 }
 
 
+void proof_graph_t::_index_edge(edge_idx_t idx)
+{
+    const edge_t &e = edge(idx);
+
+    m_maps.hypernode_to_edge.add(e.tail(), idx);
+
+    if (e.head() >= 0)
+    {
+        m_maps.hypernode_to_edge.add(e.head(), idx);
+        for (auto n_idx : hypernode(e.head()))
+            m_maps.head_node_to_edges.add(n_idx, idx);
+    }
+    else
+        m_maps.headless_edges.push_back(idx);
+    
+    for (auto n_idx : hypernode(e.tail()))
+        m_maps.tail_node_to_edges.add(n_idx, idx);
+}
+
+
 hypernode_idx_t proof_graph_t::chain(
-    const std::vector<node_idx_t> &from, const lf::axiom_t &axiom, bool is_backward)
+    const std::vector<node_idx_t> &from, const lf::axiom_view_t &axiom, bool is_backward)
 {
     /* This is a sub-routine of chain.
        @param lits  Literals whom nodes hypothesized by this chain have.
@@ -1229,7 +2061,7 @@ hypernode_idx_t proof_graph_t::chain(
        @return If this chaining is invalid, returns false. */
     auto get_substitutions = [this](
         const std::vector<node_idx_t> &from,
-        const lf::axiom_t &axiom, bool is_backward,
+        const lf::axiom_view_t &axiom, bool is_backward,
         std::vector<literal_t> *lits, hash_map<term_t, term_t> *subs,
         std::set<std::pair<term_t, term_t> > *conds) -> bool
     {
@@ -1296,23 +2128,21 @@ hypernode_idx_t proof_graph_t::chain(
             return u;
         };
 
-        const lf::logical_function_t &lhs = axiom.func.branch(0);
-        const lf::logical_function_t &rhs = axiom.func.branch(1);
-        std::vector<const literal_t*>
-            ax_to(is_backward ? axiom.func.get_lhs() : axiom.func.get_rhs()),
-            ax_from(is_backward ? axiom.func.get_rhs() : axiom.func.get_lhs());
+        lf::axiom_view_t::span_t
+            ax_to(is_backward ? axiom.lhs() : axiom.rhs()),
+            ax_from(is_backward ? axiom.rhs() : axiom.lhs());
         int n_eq(0);
 
         /* CREATE MAP OF TERMS */
         for (size_t i = 0; i < ax_from.size(); ++i)
         {
-            if (ax_from.at(i)->is_equality())
+            if (ax_from.at(i).is_equality())
             {
                 ++n_eq;
                 continue;
             }
 
-            const literal_t &li_ax = *(ax_from.at(i));
+            const literal_t &li_ax = ax_from.at(i);
             const literal_t &li_hy = node(from.at(i - n_eq)).literal();
 
             for (size_t j = 0; j<li_ax.terms.size(); ++j)
@@ -1346,10 +2176,10 @@ hypernode_idx_t proof_graph_t::chain(
         /* CHECK WHETHER NON-EQUALITIES ARE SATISFIED. */
         for (const auto &lit : ax_from)
         {
-            if (lit->is_equality() and not lit->truth)
+            if (lit.is_equality() and not lit.truth)
             {
-                const auto it1 = subs->find(lit->terms.at(0));
-                const auto it2 = subs->find(lit->terms.at(1));
+                const auto it1 = subs->find(lit.terms.at(0));
+                const auto it2 = subs->find(lit.terms.at(1));
 
                 if (it1 != subs->end() and it2 != subs->end())
                 if (it1->second == it2->second)
@@ -1420,7 +2250,7 @@ hypernode_idx_t proof_graph_t::chain(
                 }
             }
 
-            if (axiom.func.is_operator(lf::OPR_PARAPHRASE))
+            if (axiom.is_operator(lf::OPR_PARAPHRASE))
             for (auto idx : from)
             {
                 auto _edges = search_edges_with_node_in_head(idx);
@@ -1467,10 +2297,9 @@ hypernode_idx_t proof_graph_t::chain(
 #endif
 
         /* SUBSTITUTE TERMS IN LITERALS */
-        lits->assign(ax_to.size(), literal_t());
+        lits->assign(ax_to.begin(), ax_to.end());
         for (size_t i = 0; i < ax_to.size(); ++i)
         {
-            (*lits)[i] = *ax_to.at(i);
             for (size_t j = 0; j < (*lits)[i].terms.size(); ++j)
             {
                 term_t &term = (*lits)[i].terms[j];
@@ -1495,7 +2324,7 @@ hypernode_idx_t proof_graph_t::chain(
         {
             enumerate_dependent_edges(*it_n, &dep_edges);
 
-            const hash_set<node_idx_t> &rels = node(*it_n).relatives();
+            const node_set_t &rels = node(*it_n).relatives();
             evidences.insert(rels.begin(), rels.end());
         }
 
@@ -1514,7 +2343,7 @@ hypernode_idx_t proof_graph_t::chain(
         for (auto it_n = evidences.begin(); it_n != evidences.end(); ++it_n)
         if (node(*it_n).is_equality_node())
         {
-            const std::vector<term_t> &terms = node(*it_n).literal().terms;
+            const term_array_t &terms = node(*it_n).literal().terms;
             eqs.insert(std::make_pair(terms.at(0), terms.at(1)));
         }
 
@@ -1543,7 +2372,7 @@ hypernode_idx_t proof_graph_t::chain(
 #endif
 
     auto print_for_debug = [this](
-        const lf::axiom_t &axiom, bool is_backward,
+        const lf::axiom_view_t &axiom, bool is_backward,
         pg::hypernode_idx_t from, pg::hypernode_idx_t to)
     {
         const std::vector<pg::node_idx_t>
@@ -1605,6 +2434,7 @@ hypernode_idx_t proof_graph_t::chain(
     /* ADD EDGE */
     edge_type_e type = (is_backward ? EDGE_HYPOTHESIZE : EDGE_IMPLICATION);
     edge_idx_t edge_idx = add_edge(edge_t(type, idx_hn_from, idx_hn_to, axiom.id));
+    _update_dependencies(edge_idx);
 
     /* ADD CONDITIONS FOR CHAIN */
     {
@@ -1618,16 +2448,16 @@ hypernode_idx_t proof_graph_t::chain(
 
         // EQUALITY IN EVIDENCES IN THE AXIOM ARE CONSIDERED AS CONDITIONS.
         // (NOW, WE DON'T CONSIDER TRUE-EQUALITY LITERALS IN ax_from)
-        auto ax_from = (is_backward ? axiom.func.get_rhs() : axiom.func.get_lhs());
+        auto ax_from = (is_backward ? axiom.rhs() : axiom.lhs());
         std::list< std::pair<term_t, term_t> >
             *cond_neq = &m_neqs_of_conditions_for_chain[edge_idx],
             *cond_sub = &m_subs_of_conditions_for_chain[edge_idx];
 
         for (auto it = ax_from.begin(); it != ax_from.end(); ++it)
-        if ((*it)->is_equality() and not (*it)->truth)
+        if (it->is_equality() and not it->truth)
         {
-            term_t t1 = (*it)->terms.at(0);
-            term_t t2 = (*it)->terms.at(1);
+            term_t t1 = it->terms.at(0);
+            term_t t2 = it->terms.at(1);
 
             if (not t1.is_constant())
             {
@@ -1706,18 +2536,18 @@ std::list<std::pair<arity_t, arity_t> > proof_graph_t::get_gaps_on_edge(edge_idx
 
     if (e.is_chain_edge())
     {
-        lf::axiom_t ax = kb::knowledge_base_t::instance()->get_axiom(e.axiom_id());
-        std::vector<const lf::logical_function_t*> branches_tail;
+        auto ax = kb::knowledge_base_t::instance()->get_cached_axiom(e.axiom_id());
+        lf::axiom_view_t::span_t lits_tail(NULL, NULL);
 
         if (e.type() == EDGE_IMPLICATION)
-            ax.func.branch(0).enumerate_literal_branches(&branches_tail);
+            lits_tail = ax->lhs();
         else if (e.type() == EDGE_HYPOTHESIZE)
-            ax.func.branch(1).enumerate_literal_branches(&branches_tail);
+            lits_tail = ax->rhs();
 
         int n_eq = 0;
-        for (index_t i = 0; i < branches_tail.size(); ++i)
+        for (index_t i = 0; i < lits_tail.size(); ++i)
         {
-            const literal_t &lit = branches_tail.at(i)->literal();
+            const literal_t &lit = lits_tail.at(i);
             if (lit.is_equality())
                 ++n_eq;
             else
@@ -1744,13 +2574,12 @@ std::list<std::pair<arity_t, arity_t> > proof_graph_t::get_gaps_on_edge(edge_idx
 std::list<std::tuple<node_idx_t, node_idx_t, unifier_t> >
 proof_graph_t::enumerate_mutual_exclusive_nodes() const
 {
-    const hash_map<node_idx_t, hash_map<node_idx_t, unifier_t> >
+    const util::triangular_matrix_t<node_idx_t, unifier_t>
         &muexs = m_mutual_exclusive_nodes;
     std::list<std::tuple<node_idx_t, node_idx_t, unifier_t> > out;
 
-    for (auto it1 = muexs.begin(); it1 != muexs.end(); ++it1)
-    for (auto it2 = it1->second.begin(); it2 != it1->second.end(); ++it2)
-        out.push_back(std::make_tuple(it1->first, it2->first, it2->second));
+    for (auto it = muexs.begin(); it != muexs.end(); ++it)
+        out.push_back(std::make_tuple(it->first(), it->second(), it->value));
 
     return out;
 }
@@ -1759,8 +2588,7 @@ proof_graph_t::enumerate_mutual_exclusive_nodes() const
 std::list<hash_set<edge_idx_t> >
 proof_graph_t::enumerate_mutual_exclusive_edges() const
 {
-    const hash_map<edge_idx_t, hash_set<edge_idx_t> >
-        muexs(m_mutual_exclusive_edges);
+    const hash_map<edge_idx_t, node_set_t> &muexs = m_mutual_exclusive_edges;
     std::set<util::comparable_list<edge_idx_t> > buf;
 
     for (auto it = muexs.begin(); it != muexs.end(); ++it)
@@ -1795,14 +2623,22 @@ void proof_graph_t::_generate_mutual_exclusions(
             "Inconsistent: " + node(target).to_string() + ", "
             + node(idx2).to_string() + uni.to_string());
 
-        node_idx_t
-            n1((target >= idx2) ? idx2 : target),
-            n2((target >= idx2) ? target : idx2);
-        m_mutual_exclusive_nodes[n1][n2] = uni;
+        _add_mutual_exclusion(target, idx2, uni);
     }
 }
 
 
+void proof_graph_t::_add_mutual_exclusion(
+    node_idx_t n1, node_idx_t n2, const unifier_t &uni)
+{
+    if (n1 > n2) std::swap(n1, n2);
+
+    m_mutual_exclusive_nodes.assign(n1, n2, uni);
+    m_mutual_exclusive_node_sets.at(n1).insert(n2);
+    m_mutual_exclusive_node_sets.at(n2).insert(n1);
+}
+
+
 void proof_graph_t::_enumerate_mutual_exclusion_for_inconsistent_nodes(
     const literal_t &target1,
     std::list<std::tuple<node_idx_t, unifier_t> > *out) const
@@ -1810,8 +2646,7 @@ void proof_graph_t::_enumerate_mutual_exclusion_for_inconsistent_nodes(
     if (target1.is_equality()) return;
 
     const kb::knowledge_base_t *kb = kb::knowledge_base_t::instance();
-    std::string arity = target1.get_arity();
-    kb::arity_id_t id1 = kb->search_arity_id(arity);
+    kb::arity_id_t id1 = kb->search_arity_id(target1);
 
     for (auto p1 : m_maps.arity_to_nodes)
     {
@@ -1852,6 +2687,11 @@ void proof_graph_t::_enumerate_mutual_exclusion_for_inconsistent_nodes(
 }
 
 
+/** Threads are used only when each of them can check this many pairs at least,
+ *  because waking threads for a few pairs costs more than checking them. */
+static const size_t MIN_PAIRS_PER_THREAD_FOR_UNIFICATION = 64;
+
+
 void proof_graph_t::_generate_unification_assumptions(node_idx_t target)
 {
     if (node(target).literal().is_equality())
@@ -1862,10 +2702,11 @@ void proof_graph_t::_generate_unification_assumptions(node_idx_t target)
     {
         const literal_t &lit = node(target).literal();
         hash_set<node_idx_t> candidates;
+        std::vector<node_idx_t> pairs;
         std::list<node_idx_t> unifiables;
-        unifier_t unifier;
 
-        enumerate_nodes_softly_unifiable(lit.get_arity(), &candidates);
+        enumerate_nodes_softly_unifiable(lit, &candidates);
+        pairs.reserve(candidates.size());
 
         for (auto n : candidates)
         {
@@ -1879,22 +2720,69 @@ void proof_graph_t::_generate_unification_assumptions(node_idx_t target)
             if (_is_considered_unification(n1, n2)) continue;
             else m_temporal.considered_unifications.insert(n1, n2); // ADD TO LOG
 
+            pairs.push_back(n);
+        }
+
+        // UNIFICATIONS ARE APPLIED IN ASCENDING ORDER OF NODE INDICES,
+        // SO THAT THE GRAPH DOES NOT DEPEND ON THE ITERATION ORDER OF candidates.
+        std::sort(pairs.begin(), pairs.end());
+
+        /* Checks unifiability of target and pairs[i] without modifying the graph. */
+        auto check = [this, target](node_idx_t n, unifier_t *unifier) -> bool
+        {
+            node_idx_t n1 = target;
+            node_idx_t n2 = n;
+            if (n1 > n2) std::swap(n1, n2);
+
             // IF ONE IS THE ANCESTOR OF ANOTHER, THE PAIR CANNOT UNIFY.
             if (node(n1).ancestors().count(n2) > 0 or
                 node(n2).ancestors().count(n1) > 0)
-                continue;
+                return false;
 
             bool unifiable = check_unifiability(
-                node(n1).literal(), node(n2).literal(), false, &unifier);
+                node(n1).literal(), node(n2).literal(), false, unifier);
 
             // FILTERING WITH CO-EXISTENCY OF UNIFIED NODES
 #ifndef DISABLE_CANCELING
             if (unifiable)
-                unifiable = _check_nodes_coexistability(n1, n2, &unifier);
+                unifiable = _check_nodes_coexistability(n1, n2, unifier);
 #endif
 
-            if (unifiable and can_unify_nodes(n1, n2))
-                unifiables.push_back(n);
+            return unifiable;
+        };
+
+        std::vector<char> results(pairs.size(), 0);
+
+        if (m_thread_pool and
+            pairs.size() >= m_thread_pool->size() * MIN_PAIRS_PER_THREAD_FOR_UNIFICATION)
+        {
+            /* EACH THREAD TAKES THE NEXT UNCHECKED PAIR.
+             * THE GRAPH IS NOT MODIFIED UNTIL ALL THREADS HAVE FINISHED.
+             * AN EXCEPTION IN ANY THREAD IS RETHROWN HERE. */
+            std::vector<unifier_t> unifiers(m_thread_pool->size());
+            m_thread_pool->run(pairs.size(), [&](int th, size_t i)
+            {
+                results[i] = check(pairs[i], &unifiers[th]);
+            });
+        }
+        else
+        {
+            unifier_t unifier;
+            for (size_t i = 0; i < pairs.size(); ++i)
+                results[i] = check(pairs[i], &unifier);
+        }
+
+        // can_unify_nodes MAY BE OVERRIDDEN, SO IT IS CALLED IN THE ORIGINAL ORDER.
+        for (size_t i = 0; i < pairs.size(); ++i)
+        {
+            if (not results[i]) continue;
+
+            node_idx_t n1 = target;
+            node_idx_t n2 = pairs[i];
+            if (n1 > n2) std::swap(n1, n2);
+
+            if (can_unify_nodes(n1, n2))
+                unifiables.push_back(pairs[i]);
         }
 
         return unifiables;
@@ -1902,7 +2790,7 @@ void proof_graph_t::_generate_unification_assumptions(node_idx_t target)
 
     std::list<node_idx_t> unifiables = enumerate_unifiable_nodes(target);
     const kb::unification_postponement_t* pp =
-        kb::knowledge_base_t::instance()->find_unification_postponement(node(target).arity());
+        kb::knowledge_base_t::instance()->find_unification_postponement(node(target).arity_id());
 
     /* UNIFY EACH UNIFIABLE NODE PAIR. */
     for (auto it = unifiables.begin(); it != unifiables.end(); ++it)
@@ -1925,20 +2813,17 @@ void proof_graph_t::_generate_unification_assumptions(node_idx_t target)
 
 void proof_graph_t::_chain_for_unification(node_idx_t i, node_idx_t j)
 {
-    auto add_nodes_of_transitive_unification = [this](term_t t)
+    auto add_nodes_of_transitive_unification =
+        [this](const std::list< std::pair<term_t, term_t> > &pairs)
     {
-        const hash_set<term_t> *terms = m_vc_unifiable.find_cluster(t);
-        assert(terms != NULL);
-
-        for (auto it = terms->begin(); it != terms->end(); ++it)
+        for (auto it = pairs.begin(); it != pairs.end(); ++it)
         {
-            if (t == (*it)) continue;
-            if (t.is_constant() and it->is_constant()) continue;
+            if (it->first.is_constant() and it->second.is_constant()) continue;
 
             /* GENERATE TRANSITIVE UNIFICATION. */
-            if (find_sub_node(t, *it) < 0)
+            if (find_sub_node(it->first, it->second) < 0)
             {
-                std::pair<term_t, term_t> ts = util::make_sorted_pair(t, *it);
+                std::pair<term_t, term_t> ts = util::make_sorted_pair(it->first, it->second);
                 literal_t sub("=", ts.first, ts.second);
                 node_idx_t idx = add_node(sub, NODE_HYPOTHESIS, -1, hash_set<node_idx_t>());
                 m_maps.terms_to_sub_node.insert(ts.first, ts.second, idx);
@@ -1978,13 +2863,14 @@ void proof_graph_t::_chain_for_unification(node_idx_t i, node_idx_t j)
             sub_node_idx = add_node(*sub, NODE_HYPOTHESIS, -1, parents);
 
             m_maps.terms_to_sub_node.insert(t1, t2, sub_node_idx);
-            m_vc_unifiable.add(t1, t2);
+
+            std::list< std::pair<term_t, term_t> > connected;
+            m_vc_unifiable.add(t1, t2, &connected);
 
             std::list<std::tuple<node_idx_t, unifier_t> > muex;
             get_mutual_exclusions(*sub, &muex);
             _generate_mutual_exclusions(sub_node_idx, muex);
-            add_nodes_of_transitive_unification(t1);
-            add_nodes_of_transitive_unification(t2);
+            add_nodes_of_transitive_unification(connected);
         }
 
         unify_nodes.push_back(sub_node_idx);
@@ -2028,18 +2914,6 @@ bool proof_graph_t::check_unifiability(
 }
 
 
-std::mutex g_mutex_hasher;
-
-
-size_t proof_graph_t::get_hash_of_nodes(std::list<node_idx_t> nodes)
-{
-    static std::hash<std::string> hasher;
-    std::lock_guard<std::mutex> lock(g_mutex_hasher);
-    nodes.sort();
-    return hasher(util::join(nodes.begin(), nodes.end(), ","));
-}
-
-
 void proof_graph_t::post_process()
 {
     IF_VERBOSE_3("Generating postponed unification assumptions...");
@@ -2049,31 +2923,23 @@ void proof_graph_t::post_process()
         {
             do_break = true;
 
-            for (auto it1 = m_temporal.postponed_unifications.begin();
-                it1 != m_temporal.postponed_unifications.end();)
+            for (auto it = m_temporal.postponed_unifications.begin();
+                it != m_temporal.postponed_unifications.end();)
             {
-                for (auto it2 = it1->second.begin(); it2 != it1->second.end();)
-                {
-                    const node_idx_t n1(it1->first), n2(*it2);
-                    const kb::unification_postponement_t *pp =
-                        kb::knowledge_base_t::instance()
-                        ->find_unification_postponement(node(n1).arity());
-                    assert(pp != NULL);
+                const node_idx_t n1(it->first()), n2(it->second());
+                const kb::unification_postponement_t *pp =
+                    kb::knowledge_base_t::instance()
+                    ->find_unification_postponement(node(n1).arity_id());
+                assert(pp != NULL);
 
-                    if (not pp->do_postpone(this, n1, n2))
-                    {
-                        _chain_for_unification(n1, n2);
-                        do_break = false;
-                        it2 = it1->second.erase(it2);
-                    }
-                    else
-                        ++it2;
+                if (not pp->do_postpone(this, n1, n2))
+                {
+                    _chain_for_unification(n1, n2);
+                    do_break = false;
+                    it = m_temporal.postponed_unifications.erase(it);
                 }
-
-                if (it1->second.empty())
-                    it1 = m_temporal.postponed_unifications.erase(it1);
                 else
-                    ++it1;
+                    ++it;
             }
         }
     }
@@ -2084,22 +2950,22 @@ void proof_graph_t::post_process()
         {
             std::set<std::pair<term_t, term_t> > muex_terms;
 
-            for (auto t1 : terms.second)
+            for (auto t1 : (*terms))
             if (t1.is_constant())
             {
-                for (auto t2 : terms.second)
+                for (auto t2 : (*terms))
                 if (t2.is_constant())
                     muex_terms.insert(util::make_sorted_pair(t1, t2));
             }
 
             for (auto ts : muex_terms)
-            for (auto t : terms.second)
+            for (auto t : (*terms))
             if (t != ts.first and t != ts.second)
             {
                 std::pair<node_idx_t, node_idx_t> ns = util::make_sorted_pair(
                     find_sub_node(ts.first, t), find_sub_node(ts.second, t));
                 if (ns.first >= 0 and ns.second >= 0 and ns.first != ns.second)
-                    m_mutual_exclusive_nodes[ns.first][ns.second] = unifier_t();
+                    _add_mutual_exclusion(ns.first, ns.second, unifier_t());
             }
         }
     }
@@ -2155,18 +3021,25 @@ hypernode_idx_t proof_graph_t::add_hypernode(
     {
         m_hypernodes.push_back(indices);
         idx = m_hypernodes.size() - 1;
-        for( auto it=indices.begin(); it!=indices.end(); ++it )
-            m_maps.node_to_hypernode[*it].insert(idx);
-
-        size_t h = get_hash_of_nodes(
-            std::list<node_idx_t>(indices.begin(), indices.end()));
-        m_maps.unordered_nodes_to_hypernode[h].insert(idx);
+        _index_hypernode(idx);
     }
     
     return idx;
 }
 
 
+void proof_graph_t::_index_hypernode(hypernode_idx_t idx)
+{
+    const std::vector<node_idx_t> &indices = hypernode(idx);
+
+    for( auto it=indices.begin(); it!=indices.end(); ++it )
+        m_maps.node_to_hypernode.add(*it, idx);
+
+    size_t h = get_hash_of_nodes(indices.begin(), indices.end());
+    m_maps.unordered_nodes_to_hypernode[h].insert(idx);
+}
+
+
 void proof_graph_t::_enumerate_mutual_exclusion_for_counter_nodes(
     const literal_t &target,
     std::list<std::tuple<node_idx_t, unifier_t> > *out) const
@@ -2259,14 +3132,14 @@ void proof_graph_t::_generate_mutual_exclusion_for_edges(
         [this](node_idx_t from, std::list< std::list<edge_idx_t> > *out)
     {
         const kb::knowledge_base_t *kb = kb::knowledge_base_t::instance();
-        const hash_set<hypernode_idx_t> *hns = this->search_hypernodes_with_node(from);
+        const std::vector<hypernode_idx_t> *hns = this->search_hypernodes_with_node(from);
         if (hns == NULL) return;
 
         // ENUMERATE EDGES CONNECTED WITH GIVEN NODE
         std::list<edge_idx_t> targets;
         for (auto it = hns->begin(); it != hns->end(); ++it)
         {
-            const hash_set<edge_idx_t> *_edges = this->search_edges_with_hypernode(*it);
+            const std::vector<edge_idx_t> *_edges = this->search_edges_with_hypernode(*it);
             if (_edges == NULL) continue;
 
             for (auto it_e = _edges->begin(); it_e != _edges->end(); ++it_e)
@@ -2312,7 +3185,7 @@ void proof_graph_t::_generate_mutual_exclusion_for_edges(
         [this](hypernode_idx_t from, std::list< std::list<edge_idx_t> > *out)
     {
         const kb::knowledge_base_t *kb = kb::knowledge_base_t::instance();
-        const hash_set<edge_idx_t> *edges = this->search_edges_with_hypernode(from);
+        const std::vector<edge_idx_t> *edges = this->search_edges_with_hypernode(from);
         if (edges == NULL) return;
 
         std::set<util::comparable_list<edge_idx_t> > exclusions;
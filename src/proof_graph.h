@@ -11,6 +11,8 @@
 #include <string>
 #include <set>
 #include <map>
+#include <deque>
+#include <memory>
 #include <ciso646>
 
 
@@ -48,6 +50,105 @@ enum node_type_e
 };
 
 
+/** A compact set of node indices, which is a bitset chunked by 64 nodes.
+ *  Only chunks which have any member are stored in ascending order,
+ *  so the size is proportional to the number of members
+ *  rather than to the number of nodes in the proof-graph.
+ *  This is also used for sets of edge indices. */
+class node_set_t
+{
+public:
+    class const_iterator
+    {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef node_idx_t value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const node_idx_t* pointer;
+        typedef node_idx_t reference;
+
+        inline const_iterator(const node_set_t *set, size_t i);
+
+        inline node_idx_t operator*() const;
+        inline const_iterator& operator++();
+        inline bool operator==(const const_iterator &x) const;
+        inline bool operator!=(const const_iterator &x) const { return not(*this == x); }
+
+    private:
+        const node_set_t *m_set;
+        size_t m_chunk;
+        unsigned long long m_bits;
+    };
+
+    /** Returns 1 if idx is a member of this, otherwise 0.
+     *  This costs a binary search on chunks and a bit test. */
+    inline size_t count(node_idx_t idx) const;
+
+    void insert(node_idx_t idx);
+    template <class It> void insert(It begin, It end);
+
+    /** Inserts all members of x, merging chunks of both. */
+    void insert(const node_set_t &x);
+
+    /** Returns whether this and x have any common member.
+     *  This costs one AND operation per pair of chunks of the same index. */
+    bool has_intersection(const node_set_t &x) const;
+
+    /** Returns members of this which are also members of x. */
+    node_set_t intersection(const node_set_t &x) const;
+
+    /** Returns members of this which are not members of x. */
+    node_set_t difference(const node_set_t &x) const;
+
+    size_t size() const;
+    inline bool empty() const { return m_chunks.empty(); }
+
+    inline const_iterator begin() const { return const_iterator(this, 0); }
+    inline const_iterator end() const { return const_iterator(this, m_chunks.size()); }
+
+    /** Writes or reads chunks by one copy. */
+    inline void write_binary(util::binary_writer_t *wr) const { wr->write_array(m_chunks); }
+
+    /** @param limit Every member read must be less than this.
+     *  @return False if the chunks read are broken or have a member out of limit. */
+    bool read_binary(util::binary_reader_t *rd, index_t limit);
+
+private:
+    static const int BITS_PER_CHUNK = 64;
+
+    struct chunk_t
+    {
+        node_idx_t index; /// The index of the first node in this chunk divided by 64.
+        unsigned long long bits;
+    };
+
+    static inline int lowest_bit(unsigned long long bits);
+    inline std::vector<chunk_t>::const_iterator find_chunk(node_idx_t chunk) const;
+
+    std::vector<chunk_t> m_chunks;
+};
+
+
+/** An append-only map from dense non-negative indices to lists of values.
+ *  Because nodes, hypernodes and edges are only appended to proof-graphs,
+ *  each list is kept in ascending order of insertion
+ *  and a value is never added twice in succession.
+ *  Lists are held in a deque so that pointers returned by get()
+ *  remain valid while other keys are added, as with hash_map. */
+template <class Value> class adjacency_list_t
+{
+public:
+    /** Returns the list of values for key, or NULL if it is empty. */
+    inline const std::vector<Value>* get(index_t key) const;
+
+    inline void add(index_t key, const Value &value);
+    inline void clear() { m_lists.clear(); }
+
+private:
+    std::deque< std::vector<Value> > m_lists;
+};
+
+
 /** A struct of node in proof-graphs. */
 class node_t
 {
@@ -64,7 +165,7 @@ public:
 
     inline node_type_e type() const { return m_type; }
     inline const literal_t& literal() const { return m_literal; }
-    inline arity_t arity() const { return m_literal.get_arity(); }
+    inline const arity_t& arity() const { return m_literal.get_arity(); }
     inline kb::arity_id_t arity_id() const { return m_arity_id; }
 
     /** Returns the index of this node in a proof-graph. */
@@ -78,10 +179,10 @@ public:
     inline const hash_set<pg::node_idx_t>& parents() const;
 
     /** Returns nodes between this and observations which this explains. */
-    inline const hash_set<pg::node_idx_t>& ancestors() const;
+    inline const node_set_t& ancestors() const;
 
     /** Returns nodes which must be hypothesized to hypothesize this. */
-    inline const hash_set<pg::node_idx_t>& relatives() const;
+    inline const node_set_t& relatives() const;
 
     /** Returns the index of hypernode
      *  which was instantiated for instantiation of this node.
@@ -104,6 +205,11 @@ public:
     inline std::string to_string() const;
 
 private:
+    friend class proof_graph_t;
+
+    /** Is used only on reading a proof-graph from binary. */
+    node_t() {}
+
     node_type_e m_type;
     literal_t   m_literal;
     node_idx_t  m_index;
@@ -112,8 +218,8 @@ private:
     kb::arity_id_t m_arity_id;
 
     hash_set<node_idx_t> m_parents;
-    hash_set<node_idx_t> m_ancestors;
-    hash_set<node_idx_t> m_relatives;
+    node_set_t m_ancestors;
+    node_set_t m_relatives;
 };
 
 
@@ -256,8 +362,9 @@ public:
         const proof_graph_t *m_graph;
         node_idx_t m_pivot;
 
-        std::set<kb::arity_pattern_t> m_patterns;
-        std::set<kb::arity_pattern_t>::const_iterator m_pt_iter;
+        std::vector<kb::arity_pattern_id_t> m_patterns;
+        std::vector<kb::arity_pattern_id_t>::const_iterator m_pt_iter;
+        kb::arity_pattern_view_t m_pattern; /// The pattern of m_pt_iter.
 
         std::list<std::vector<node_idx_t> > m_targets;
         std::list<std::pair<axiom_id_t, bool> > m_axioms;
@@ -300,16 +407,16 @@ public:
     hypernode_idx_t add_hypernode(const std::vector<node_idx_t> &indices);
 
     /** Perform backward-chaining from the target node.
-     *  @param axiom The logical function of implication to use.
+     *  @param axiom The view of implication to use.
      *  @return Index of new hypernode resulted in backward-chaining. */
     inline hypernode_idx_t backward_chain(
-        const std::vector<node_idx_t> &target, const lf::axiom_t &axiom);
+        const std::vector<node_idx_t> &target, const lf::axiom_view_t &axiom);
     
     /** Perform forward-chaining from the target node.
-     *  @param axiom The logical function of implication to use.
+     *  @param axiom The view of implication to use.
      *  @return Index of new hypernode resulted in forward-chaining. */
     inline hypernode_idx_t forward_chain(
-        const std::vector<node_idx_t> &target, const lf::axiom_t &axiom);
+        const std::vector<node_idx_t> &target, const lf::axiom_view_t &axiom);
 
     inline const std::vector<node_t>& nodes() const;
     inline const node_t& node(node_idx_t i) const;
@@ -345,11 +452,11 @@ public:
     /** Return pointer of set of nodes whose literal has given predicate.
      *  If any node was found, return NULL. */
     inline const hash_set<node_idx_t>* search_nodes_with_arity(const arity_t &arity) const;
-    inline const hash_set<node_idx_t>* search_nodes_with_arity(kb::arity_id_t arity) const;
+    inline const std::vector<node_idx_t>* search_nodes_with_arity(kb::arity_id_t arity) const;
 
     /** Return pointer of set of nodes whose depth is equal to given value.
      *  If any node was found, return NULL. */
-    inline const hash_set<node_idx_t>* search_nodes_with_depth(depth_t depth) const;
+    inline const std::vector<node_idx_t>* search_nodes_with_depth(depth_t depth) const;
 
     /** Return a set of nodes which is unifiable with a literal of given arity.
      *  The threshold of category-table is given
@@ -357,16 +464,21 @@ public:
     void enumerate_nodes_softly_unifiable(
         const arity_t &arity, hash_set<node_idx_t> *out) const;
 
+    /** Same as above, but uses the interned predicate and arity of lit
+     *  instead of parsing and interning the arity again. */
+    void enumerate_nodes_softly_unifiable(
+        const literal_t &lit, hash_set<node_idx_t> *out) const;
+
     /** Return set of nodes whose literal is equal to given literal. */
     hash_set<node_idx_t> enumerate_nodes_with_literal(const literal_t &lit) const;
 
     /** Return the indices of edges connected with given hypernode.
     *  If any edge was not found, return NULL. */
-    inline const hash_set<edge_idx_t>*
+    inline const std::vector<edge_idx_t>*
         search_edges_with_hypernode(hypernode_idx_t idx) const;
-    inline const hash_set<edge_idx_t>*
+    inline const std::vector<edge_idx_t>*
         search_edges_with_node_in_tail(node_idx_t idx) const;
-    inline const hash_set<edge_idx_t>*
+    inline const std::vector<edge_idx_t>*
         search_edges_with_node_in_head(node_idx_t idx) const;
 
     /** Return the indices of edges which are related with given node. */
@@ -395,11 +507,11 @@ public:
     
     /** Return pointer of set of indices of hypernode which has the given node as its element.
      *  If any set was found, return NULL. */
-    inline const hash_set<hypernode_idx_t>* search_hypernodes_with_node(node_idx_t i) const;
+    inline const std::vector<hypernode_idx_t>* search_hypernodes_with_node(node_idx_t i) const;
 
-    /** Return the index of first one of hypernodes whose elements are same as given indices.
-     *  If any hypernode was not found, return -1.  */
-    template<class It> const hash_set<hypernode_idx_t>*
+    /** Return indices of hypernodes whose elements are same as given indices
+     *  regardless of their order. If any hypernode was not found, return empty. */
+    template<class It> std::vector<hypernode_idx_t>
         find_hypernode_with_unordered_nodes(It begin, It end) const;
 
     /** Return the index of hypernode whose elements are same as given indices.
@@ -416,8 +528,8 @@ public:
     /** Returns index of the unifying edge which unifies node i & j. */
     edge_idx_t find_unifying_edge(node_idx_t i, node_idx_t j) const;
 
-    inline const hash_set<term_t>* find_variable_cluster(term_t t) const;
-    std::list< const hash_set<term_t>* > enumerate_variable_clusters() const;
+    inline const std::vector<term_t>* find_variable_cluster(term_t t) const;
+    std::list< const std::vector<term_t>* > enumerate_variable_clusters() const;
 
     /** Returns a list of chains which are needed to hypothesize given node. */
     hash_set<edge_idx_t> enumerate_dependent_edges(node_idx_t) const;
@@ -428,6 +540,12 @@ public:
     /** Returns a list of nodes which are needed to hypothesize given node. */
     void enumerate_dependent_nodes(node_idx_t, hash_set<node_idx_t>*) const;
 
+    /** Returns chains which are needed to hypothesize given node. */
+    inline const node_set_t& dependent_edges(node_idx_t i) const;
+
+    /** Returns nodes which are needed to hypothesize given node. */
+    inline const node_set_t& dependent_nodes(node_idx_t i) const;
+
     /** Returns gaps of predicate on given edge.
      *  The first is expected arity and the second is actual arity. */
     std::list<std::pair<arity_t, arity_t> > get_gaps_on_edge(edge_idx_t) const;
@@ -453,7 +571,7 @@ public:
 
     /** Returns whether given axioms has already applied to given hypernode. */
     bool axiom_has_applied(
-        hypernode_idx_t hn, const lf::axiom_t &ax, bool is_backward) const;
+        hypernode_idx_t hn, const lf::axiom_view_t &ax, bool is_backward) const;
 
     inline void add_attribute(const std::string &name, const std::string &value);
 
@@ -461,37 +579,61 @@ public:
 
     virtual void print(std::ostream *os) const;
 
+    /** Appends this to os as a binary record, which can be loaded by read_binary.
+     *  Records of plural proof-graphs can be written to the same file.
+     *  Call this after post_process. */
+    void write_binary(std::ostream *os) const;
+
+    /** Loads the record named name() from a file written by write_binary.
+     *  The knowledge-base must be same as one used on writing,
+     *  because axiom-ids and arity-ids are written as they are.
+     *  Each file is indexed by names of records on the first call and kept open.
+     *  @return Whether the record was found. */
+    bool read_binary(const std::string &filename);
+
 protected:
-    /** A class of variable cluster.
-     *  Elements of this are terms which are unifiable each other. */
+    /** A set of clusters of unifiable terms, implemented as union-find.
+     *  Each cluster is represented by its root term,
+     *  which holds the list of members of the cluster.
+     *  Paths are compressed only in add, so that const methods
+     *  do not modify this and can be called from plural threads. */
     class unifiable_variable_clusters_set_t
     {
     public:
-        unifiable_variable_clusters_set_t() : m_idx_new_cluster(0) {}
-        
-        /** Add unifiability of terms t1 & t2. */
-        void add(term_t t1, term_t t2);
+        /** Add unifiability of terms t1 & t2.
+         *  @param[out] out If not NULL, every pair of terms which gets connected
+         *                  by this addition is added to it once.
+         *                  These are candidates of transitive unification. */
+        void add(term_t t1, term_t t2,
+            std::list< std::pair<term_t, term_t> > *out = NULL);
 
         void merge(const unifiable_variable_clusters_set_t &vc);
 
-        inline const hash_map<index_t, hash_set<term_t> >& clusters() const;
-        inline const hash_set<term_t>* find_cluster(term_t t) const;
+        /** Returns members of every cluster, ordered by the index of its root. */
+        std::list< const std::vector<term_t>* > clusters() const;
+        inline const std::vector<term_t>* find_cluster(term_t t) const;
         
         /** Check whether terms t1 & t2 are unifiable. */
         inline bool is_in_same_cluster(term_t t1, term_t t2) const;
         
     private:
-        int m_idx_new_cluster;
-        /** List of clusters.
-         *  We use hash-map for erasure with keeping indices. */
-        hash_map<index_t, hash_set<term_t> > m_clusters;
+        friend class proof_graph_t;
+
+        /** Returns the index of the root of the cluster which i joins.
+         *  The const one does not compress paths on the way,
+         *  which are kept short by union by size. */
+        inline index_t find_root(index_t i) const;
+        inline index_t find_root(index_t i);
+        index_t get_index(term_t t);
 
-        /** Mapping from name of a variable
-         *  to the index of cluster which the variable joins. */
-        hash_map<term_t, index_t> m_map_v2c;
+        /** Mapping from a term to its index in m_parents. */
+        hash_map<term_t, index_t> m_term2idx;
 
-        /** All variables included in this cluster-set. */
-        hash_set<term_t> m_variables;
+        /** The parent of each term. A root is its own parent. */
+        std::vector<index_t> m_parents;
+
+        /** Members of the cluster of each root. Empty for non-roots. */
+        std::vector< std::vector<term_t> > m_members;
     };
 
     /** Get whether it is possible to unify literals p1 and p2.     
@@ -502,8 +644,9 @@ protected:
         const literal_t &p1, const literal_t &p2,
         bool do_ignore_truthment, unifier_t *out = NULL);
 
-    /** Return hash of node indices' list. */
-    static size_t get_hash_of_nodes(std::list<node_idx_t> nodes);
+    /** Return hash of node indices, which does not depend on their order.
+     *  This needs neither allocation nor lock. */
+    template <class It> static size_t get_hash_of_nodes(It begin, It end);
 
     /** Adds a new node and updates maps.
      *  Here, mutual-exclusion and unification-assumptions for the new node
@@ -520,18 +663,29 @@ protected:
      *  @return The index of added new edge. */
     edge_idx_t add_edge(const edge_t &edge);
 
+    /** Are sub-routines of add_node, add_hypernode and add_edge.
+     *  Each registers an element which has been added to maps.
+     *  These are also used to restore maps on reading binary. */
+    void _index_node(node_idx_t idx);
+    void _index_hypernode(hypernode_idx_t idx);
+    void _index_edge(edge_idx_t idx);
+
     /** Performs backward-chaining or forward-chaining.
      *  Correspondence of each term is considered on chaining.
      *  @return Index of the new hypernode. If chaining has failed, returns -1. */
     hypernode_idx_t chain(
         const std::vector<node_idx_t> &from,
-        const lf::axiom_t &axiom, bool is_backward);
+        const lf::axiom_view_t &axiom, bool is_backward);
 
     /** Get mutual exclusions around the literal 'target'. */
     void get_mutual_exclusions(
         const literal_t &target,
         std::list<std::tuple<node_idx_t, unifier_t> > *muexs) const;
 
+    /** Adds nodes whose predicates are softly unifiable with given arity. */
+    void _enumerate_nodes_softly_unifiable(
+        kb::arity_id_t id, hash_set<node_idx_t> *out) const;
+
     /** Is a sub-routine of add_node.
      *  Generates unification assumptions between target node
      *  and other nodes which have same predicate as target node has. */
@@ -544,6 +698,15 @@ protected:
         node_idx_t target,
         const std::list<std::tuple<node_idx_t, unifier_t> > &muexs);
 
+    /** Sets mutual-exclusiveness between n1 and n2
+     *  to both of m_mutual_exclusive_nodes and m_mutual_exclusive_node_sets. */
+    void _add_mutual_exclusion(node_idx_t n1, node_idx_t n2, const unifier_t &uni);
+
+    /** Is a sub-routine of chain.
+     *  Sets dependencies of nodes in the head of given edge
+     *  from dependencies of nodes in its tail. */
+    void _update_dependencies(edge_idx_t idx);
+
     /** Is a sub-routine of _get_mutual_exclusion.
      *  Adds mutual-exclusions for target and nodes being inconsistent with it. */
     void _enumerate_mutual_exclusion_for_inconsistent_nodes(
@@ -612,12 +775,30 @@ protected:
     hash_map<std::string, std::string> m_attributes;
 
     float m_threshold_distance_for_soft_unify;
+
+    /** Threads to check unifiability of candidate pairs.
+     *  The number is given through the parameter "lhs_thread_num".
+     *  NULL if it is one. */
+    std::unique_ptr<util::thread_pool_t> m_thread_pool;
     
     /** Mutual exclusiveness betwen two nodes.
      *  If unifier of third value is satisfied, the node of the first key and the node of the second key cannot be hypothesized together. */
     util::triangular_matrix_t<node_idx_t, unifier_t> m_mutual_exclusive_nodes;
 
-    hash_map<edge_idx_t, hash_set<edge_idx_t> > m_mutual_exclusive_edges;
+    /** The i-th element is the set of nodes mutual-exclusive with node i.
+     *  This is used to find mutual-exclusions by bitwise operations. */
+    std::vector<node_set_t> m_mutual_exclusive_node_sets;
+
+    hash_map<edge_idx_t, node_set_t> m_mutual_exclusive_edges;
+
+    /** Edges and nodes on which each node depends.
+     *  The i-th element corresponds to node i,
+     *  and is updated when a chain hypothesizes the node. */
+    struct dependency_t
+    {
+        node_set_t edges, nodes;
+    };
+    std::vector<dependency_t> m_dependencies;
     
     unifiable_variable_clusters_set_t m_vc_unifiable;
 
@@ -639,12 +820,17 @@ protected:
 
         /** Set of pair of nodes
         *  whose unifiability has been already considered.
-        *  KEY and VALUE express node pair, and KEY is less than VALUE. */
+        *  The smaller node index is the first of each pair. */
         util::pair_set_t<node_idx_t> considered_unifications;
 
         /** Used in _check_nodes_coexistability. */
         mutable util::triangular_matrix_t<node_idx_t, bool> coexistability_logs;
 
+        /** Map from arity-id to unary predicates
+         *  whose semantic gap from the arity is below the threshold.
+         *  Used in enumerate_nodes_softly_unifiable. */
+        mutable hash_map<kb::arity_id_t, std::vector<predicate_t> > soft_unifiable_predicates;
+
         std::map<std::pair<pg::node_idx_t, term_idx_t>, unsigned long int> argument_set_ids;
     } m_temporal;
 
@@ -660,8 +846,9 @@ protected:
          *   - VALUE : Index of node of "KEY1 != KEY2". */
         util::triangular_matrix_t<term_t, node_idx_t> terms_to_negsub_node;
 
-        /** Map from depth to indices of nodes assigned the depth. */
-        hash_map<depth_t, hash_set<node_idx_t> > depth_to_nodes;
+        /** Map from depth to indices of nodes assigned the depth.
+         *  Because depth of nodes can be -1, the key is depth plus one. */
+        adjacency_list_t<node_idx_t> depth_to_nodes;
 
         /** Map from axiom-id to hypernodes which have been applied the axiom. */
         hash_map< axiom_id_t, hash_set<hypernode_idx_t> >
@@ -676,20 +863,27 @@ protected:
             predicate_to_nodes;
 
         /** Map to get hypernodes which include given node. */
-        hash_map<node_idx_t, hash_set<hypernode_idx_t> > node_to_hypernode;
+        adjacency_list_t<hypernode_idx_t> node_to_hypernode;
 
         /** Map to get hypernodes from hash of unordered-nodes. */
         hash_map<size_t, hash_set<hypernode_idx_t> > unordered_nodes_to_hypernode;
 
         /** Map to get edges connecting given node. */
-        hash_map<hypernode_idx_t, hash_set<edge_idx_t> > hypernode_to_edge;
+        adjacency_list_t<edge_idx_t> hypernode_to_edge;
+
+        /** Edges whose head is empty, i.e. unification edges
+         *  which need no equality. These are what hypernode -1 refers to. */
+        std::vector<edge_idx_t> headless_edges;
 
-        hash_map<node_idx_t, hash_set<edge_idx_t> > tail_node_to_edges, head_node_to_edges;
+        adjacency_list_t<edge_idx_t> tail_node_to_edges, head_node_to_edges;
 
         /** Map to get nodes which have given term. */
         hash_map<term_t, hash_set<node_idx_t> > term_to_nodes;
 
-        hash_map<kb::arity_id_t, hash_set<node_idx_t> > arity_to_nodes;
+        /** Map from arity-id to indices of nodes.
+         *  This is keyed by hash because arity-ids are dense in the KB,
+         *  but only few of them appear in a proof-graph. */
+        hash_map<kb::arity_id_t, std::vector<node_idx_t> > arity_to_nodes;
     } m_maps;
 };
 
@@ -15,19 +15,111 @@ namespace pg
 
 
 
+inline node_set_t::const_iterator::const_iterator(const node_set_t *set, size_t i)
+    : m_set(set), m_chunk(i),
+      m_bits(i < set->m_chunks.size() ? set->m_chunks[i].bits : 0)
+{}
+
+
+inline node_idx_t node_set_t::const_iterator::operator*() const
+{
+    return m_set->m_chunks[m_chunk].index * BITS_PER_CHUNK + lowest_bit(m_bits);
+}
+
+
+inline node_set_t::const_iterator& node_set_t::const_iterator::operator++()
+{
+    m_bits &= m_bits - 1;
+
+    if (m_bits == 0 and ++m_chunk < m_set->m_chunks.size())
+        m_bits = m_set->m_chunks[m_chunk].bits;
+
+    return *this;
+}
+
+
+inline bool node_set_t::const_iterator::operator==(const const_iterator &x) const
+{
+    return m_chunk == x.m_chunk and m_bits == x.m_bits;
+}
+
+
+inline size_t node_set_t::count(node_idx_t idx) const
+{
+    if (idx < 0) return 0;
+
+    auto found = find_chunk(idx / BITS_PER_CHUNK);
+    if (found == m_chunks.end() or found->index != idx / BITS_PER_CHUNK)
+        return 0;
+
+    return (found->bits >> (idx % BITS_PER_CHUNK)) & 1ull;
+}
+
+
+template <class It> void node_set_t::insert(It begin, It end)
+{
+    for (auto it = begin; it != end; ++it)
+        insert(*it);
+}
+
+
+inline int node_set_t::lowest_bit(unsigned long long bits)
+{
+#ifdef _WIN32
+    int i(0);
+    for (; (bits & 1ull) == 0; bits >>= 1) ++i;
+    return i;
+#else
+    return __builtin_ctzll(bits);
+#endif
+}
+
+
+inline std::vector<node_set_t::chunk_t>::const_iterator
+node_set_t::find_chunk(node_idx_t chunk) const
+{
+    return std::lower_bound(
+        m_chunks.begin(), m_chunks.end(), chunk,
+        [](const chunk_t &c, node_idx_t i) { return c.index < i; });
+}
+
+
+template <class Value> inline const std::vector<Value>*
+adjacency_list_t<Value>::get(index_t key) const
+{
+    if (key < 0 or key >= static_cast<index_t>(m_lists.size()))
+        return NULL;
+    return m_lists[key].empty() ? NULL : &m_lists[key];
+}
+
+
+template <class Value> inline void
+adjacency_list_t<Value>::add(index_t key, const Value &value)
+{
+    assert(key >= 0);
+
+    if (key >= static_cast<index_t>(m_lists.size()))
+        m_lists.resize(key + 1);
+
+    std::vector<Value> &list = m_lists[key];
+    if (list.empty() or list.back() != value)
+        list.push_back(value);
+}
+
+
 inline const hash_set<pg::node_idx_t>& node_t::parents() const
 {
     return m_parents;
 }
 
 
-inline const hash_set<pg::node_idx_t>& node_t::ancestors() const
+inline const node_set_t& node_t::ancestors() const
 {
     return m_ancestors;
 }
 
 
-inline const hash_set<pg::node_idx_t>& node_t::relatives() const
+inline const node_set_t& node_t::relatives() const
 {
     return m_relatives;
 }
@@ -140,16 +232,11 @@ inline bool unifier_t::empty() const
 }
 
 
-inline const hash_map<index_t, hash_set<term_t> >&
-proof_graph_t::unifiable_variable_clusters_set_t::clusters() const
-{ return m_clusters; }
-
-
-inline const hash_set<term_t>* proof_graph_t
+inline const std::vector<term_t>* proof_graph_t
     ::unifiable_variable_clusters_set_t::find_cluster(term_t t) const
 {
-    auto it = m_map_v2c.find(t);
-    return (it != m_map_v2c.end()) ? &m_clusters.at(it->second) : NULL;
+    auto it = m_term2idx.find(t);
+    return (it != m_term2idx.end()) ? &m_members[find_root(it->second)] : NULL;
 }
 
 
@@ -157,11 +244,36 @@ inline bool
 proof_graph_t::unifiable_variable_clusters_set_t::is_in_same_cluster(
     term_t t1, term_t t2 ) const
 {
-    auto i_v1 = m_map_v2c.find(t1);
-    if( i_v1 == m_map_v2c.end() ) return false;
-    auto i_v2 = m_map_v2c.find(t2);
-    if( i_v2 == m_map_v2c.end() ) return false;
-    return ( i_v1->second == i_v2->second );
+    auto i_v1 = m_term2idx.find(t1);
+    if( i_v1 == m_term2idx.end() ) return false;
+    auto i_v2 = m_term2idx.find(t2);
+    if( i_v2 == m_term2idx.end() ) return false;
+    return ( find_root(i_v1->second) == find_root(i_v2->second) );
+}
+
+
+inline index_t
+proof_graph_t::unifiable_variable_clusters_set_t::find_root(index_t i) const
+{
+    while (m_parents[i] != i)
+        i = m_parents[i];
+    return i;
+}
+
+
+inline index_t
+proof_graph_t::unifiable_variable_clusters_set_t::find_root(index_t i)
+{
+    index_t root(static_cast<const unifiable_variable_clusters_set_t*>(this)->find_root(i));
+
+    while (m_parents[i] != root)
+    {
+        index_t next = m_parents[i];
+        m_parents[i] = root;
+        i = next;
+    }
+
+    return root;
 }
 
 
@@ -181,14 +293,14 @@ inline node_idx_t proof_graph_t::
 
 
 inline hypernode_idx_t proof_graph_t::backward_chain(
-    const std::vector<node_idx_t> &target, const lf::axiom_t &axiom)
+    const std::vector<node_idx_t> &target, const lf::axiom_view_t &axiom)
 {
     return chain(target, axiom, true);
 }
 
 
 inline hypernode_idx_t proof_graph_t::forward_chain(
-    const std::vector<node_idx_t> &target, const lf::axiom_t &axiom)
+    const std::vector<node_idx_t> &target, const lf::axiom_view_t &axiom)
 {
     return chain(target, axiom, false);
 }
@@ -280,7 +392,7 @@ proof_graph_t::search_nodes_with_arity(const arity_t &arity) const
 }
 
 
-inline const hash_set<node_idx_t>*
+inline const std::vector<node_idx_t>*
 proof_graph_t::search_nodes_with_arity(const kb::arity_id_t arity) const
 {
     auto found = m_maps.arity_to_nodes.find(arity);
@@ -288,53 +400,79 @@ proof_graph_t::search_nodes_with_arity(const kb::arity_id_t arity) const
 }
 
 
-inline const hash_set<node_idx_t>*
+inline const std::vector<node_idx_t>*
 proof_graph_t::search_nodes_with_depth(depth_t depth) const
 {
-    auto it = m_maps.depth_to_nodes.find( depth );
-    return (it == m_maps.depth_to_nodes.end()) ? NULL : &it->second;
+    return m_maps.depth_to_nodes.get(depth + 1);
 }
 
 
-inline const hash_set<edge_idx_t>*
+inline const std::vector<edge_idx_t>*
     proof_graph_t::search_edges_with_hypernode( hypernode_idx_t idx ) const
 {
-    auto it = m_maps.hypernode_to_edge.find(idx);
-    return (it == m_maps.hypernode_to_edge.end()) ? NULL : &it->second;
+    if (idx < 0)
+        return m_maps.headless_edges.empty() ? NULL : &m_maps.headless_edges;
+    return m_maps.hypernode_to_edge.get(idx);
 }
 
 
-inline const hash_set<edge_idx_t>*
+inline const std::vector<edge_idx_t>*
 proof_graph_t::search_edges_with_node_in_head(node_idx_t idx) const
 {
-    auto found = m_maps.head_node_to_edges.find(idx);
-    return (found == m_maps.head_node_to_edges.end()) ? NULL : &found->second;
+    return m_maps.head_node_to_edges.get(idx);
 }
 
 
-inline const hash_set<edge_idx_t>*
+inline const std::vector<edge_idx_t>*
 proof_graph_t::search_edges_with_node_in_tail(node_idx_t idx) const
 {
-    auto found = m_maps.tail_node_to_edges.find(idx);
-    return (found == m_maps.tail_node_to_edges.end()) ? NULL : &found->second;
+    return m_maps.tail_node_to_edges.get(idx);
 }
 
 
-inline const hash_set<hypernode_idx_t>*
+inline const std::vector<hypernode_idx_t>*
 proof_graph_t::search_hypernodes_with_node( node_idx_t node_idx ) const
 {
-    auto it = m_maps.node_to_hypernode.find( node_idx );
-    return (it == m_maps.node_to_hypernode.end()) ? NULL : &it->second;
+    return m_maps.node_to_hypernode.get(node_idx);
 }
 
 
-template<class It> const hash_set<hypernode_idx_t>*
+template<class It> std::vector<hypernode_idx_t>
 proof_graph_t::find_hypernode_with_unordered_nodes(It begin, It end) const
 {
-    size_t hash = get_hash_of_nodes(std::list<node_idx_t>(begin, end));
-    auto find = m_maps.unordered_nodes_to_hypernode.find(hash);
-    return (find != m_maps.unordered_nodes_to_hypernode.end()) ?
-        &(find->second) : NULL;
+    std::vector<hypernode_idx_t> out;
+    auto find = m_maps.unordered_nodes_to_hypernode.find(get_hash_of_nodes(begin, end));
+    if (find == m_maps.unordered_nodes_to_hypernode.end()) return out;
+
+    size_t size = std::distance(begin, end);
+
+    /* HYPERNODES WHICH MERELY HAVE THE SAME HASH ARE EXCLUDED. */
+    for (auto hn : find->second)
+    {
+        const std::vector<node_idx_t> &nodes = hypernode(hn);
+        if (nodes.size() == size and std::is_permutation(nodes.begin(), nodes.end(), begin))
+            out.push_back(hn);
+    }
+
+    return out;
+}
+
+
+template <class It> size_t proof_graph_t::get_hash_of_nodes(It begin, It end)
+{
+    /* SUM OF MIXED INDICES, WHICH IS COMMUTATIVE. */
+    unsigned long long hash(0), num(0);
+
+    for (auto it = begin; it != end; ++it, ++num)
+    {
+        unsigned long long x =
+            static_cast<unsigned long long>(*it) + 0x9e3779b97f4a7c15ull;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+        hash += x ^ (x >> 31);
+    }
+
+    return static_cast<size_t>(hash ^ (num * 0x9e3779b97f4a7c15ull));
 }
 
 
@@ -346,13 +484,25 @@ inline hypernode_idx_t
 }
 
 
-inline const hash_set<term_t>*
+inline const std::vector<term_t>*
 proof_graph_t::find_variable_cluster( term_t t ) const
 {
     return m_vc_unifiable.find_cluster(t);
 }
 
 
+inline const node_set_t& proof_graph_t::dependent_edges(node_idx_t i) const
+{
+    return m_dependencies.at(i).edges;
+}
+
+
+inline const node_set_t& proof_graph_t::dependent_nodes(node_idx_t i) const
+{
+    return m_dependencies.at(i).nodes;
+}
+
+
 template <class IterNodesArray>
 bool proof_graph_t::check_nodes_coexistability(IterNodesArray begin, IterNodesArray end) const
 {